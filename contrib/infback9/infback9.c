@@ -7,6 +7,7 @@
 #include "infback9.h"
 #include "inftree9.h"
 #include "inflate9.h"
+#include "inffast9.h"
 
 #define WSIZE 65536UL
 
@@ -108,6 +109,28 @@ void makefixed9(void) {
 
 /* Macros for inflateBack(): */
 
+/* Load returned state from inflate_fast9() */
+#define LOAD() \
+    do { \
+        put = strm->next_out; \
+        left = strm->avail_out; \
+        next = strm->next_in; \
+        have = strm->avail_in; \
+        hold = state->hold; \
+        bits = state->bits; \
+    } while (0)
+
+/* Set state from registers for inflate_fast9() */
+#define RESTORE() \
+    do { \
+        strm->next_out = put; \
+        strm->avail_out = (uInt)left; \
+        strm->next_in = next; \
+        strm->avail_in = have; \
+        state->hold = hold; \
+        state->bits = bits; \
+    } while (0)
+
 /* Clear the input bit accumulator */
 #define INITBITS() \
     do { \
@@ -455,6 +478,29 @@ int ZEXPORT inflateBack9(z_stream FAR *strm, in_func in, void FAR *in_desc,
             mode = LEN;
 
         case LEN:
+            /* use inflate_fast9() if we have enough input and output -- the
+               window is the output buffer, so it only holds earlier output
+               once it has wrapped, and then the next byte to write is the
+               oldest */
+            if (have >= FAST9_IN && left >= FAST9_OUT) {
+                state->mode = LEN;
+                state->whave = wrap ? WSIZE : 0;
+                state->wnext = 0;
+                state->lencode = lencode;
+                state->lenbits = lenbits;
+                state->distcode = distcode;
+                state->distbits = distbits;
+                RESTORE();
+                inflate_fast9(strm, WSIZE);
+                LOAD();
+                mode = state->mode;
+                if (mode == MATCH) {
+                    length = state->length;
+                    offset = state->offset;
+                }
+                break;
+            }
+
             /* get a literal, length, or end-of-block code */
             for (;;) {
                 here = lencode[BITS(lenbits)];
@@ -540,12 +586,17 @@ int ZEXPORT inflateBack9(z_stream FAR *strm, in_func in, void FAR *in_desc,
                 offset += BITS(extra);
                 DROPBITS(extra);
             }
+            Tracevv((stderr, "inflate:         distance %lu\n", offset));
+            mode = MATCH;
+                /* fallthrough */
+
+        case MATCH:
+            /* check the distance, which may come from inflate_fast9() */
             if (offset > WSIZE - (wrap ? 0: left)) {
                 strm->msg = (char *)"invalid distance too far back";
                 mode = BAD;
                 break;
             }
-            Tracevv((stderr, "inflate:         distance %lu\n", offset));
 
             /* copy match from window to output */
             do {
@@ -566,6 +617,7 @@ int ZEXPORT inflateBack9(z_stream FAR *strm, in_func in, void FAR *in_desc,
                     *put++ = *from++;
                 } while (--copy);
             } while (length != 0);
+            mode = LEN;
             break;
 
         case DONE:
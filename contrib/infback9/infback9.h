@@ -5,8 +5,9 @@
 
 /*
  * This header file and associated patches provide a decoder for PKWare's
- * undocumented deflate64 compression method (method 9).  Use with infback9.c,
- * inftree9.h, inftree9.c, and inffix9.h.  These patches are not supported.
+ * undocumented deflate64 compression method (method 9).  Use with infback9.c
+ * or inflate9.c, and with inffast9.h, inffast9.c, inftree9.h, inftree9.c, and
+ * inffix9.h.  These patches are not supported.
  * This should be compiled with zlib, since it uses zutil.h and zutil.o.
  * This code has not yet been tested on 16-bit architectures.  See the
  * comments in zlib.h for inflateBack() usage.  These functions are used
@@ -14,6 +15,12 @@
  * window must be provided.  Also if int's are 16 bits, then a zero for
  * the third parameter of the "out" function actually means 65536UL.
  * zlib.h must be included before this header file.
+ *
+ * inflate9() in inflate9.c decodes the same data a piece at a time, for use
+ * where inflateBack9()'s call-backs do not fit.  It is used like inflate()
+ * on raw deflate data, with next_in, avail_in, next_out, and avail_out, but
+ * it allocates its own 64K window, and it does not compute a check value.
+ * Initialize it with inflate9Init(), and free it with inflate9End().
  */
 
 #ifdef __cplusplus
@@ -32,6 +39,14 @@ ZEXTERN int ZEXPORT inflateBack9Init_(z_stream FAR *strm,
         inflateBack9Init_((strm), (window), \
         ZLIB_VERSION, sizeof(z_stream))
 
+ZEXTERN int ZEXPORT inflate9(z_stream FAR *strm, int flush);
+ZEXTERN int ZEXPORT inflate9End(z_stream FAR *strm);
+ZEXTERN int ZEXPORT inflate9Init_(z_stream FAR *strm,
+                                  const char *version,
+                                  int stream_size);
+#define inflate9Init(strm) \
+        inflate9Init_((strm), ZLIB_VERSION, sizeof(z_stream))
+
 #ifdef __cplusplus
 }
 #endif
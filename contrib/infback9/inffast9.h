@@ -0,0 +1,15 @@
+/* inffast9.h -- header to use inffast9.c
+ * Copyright (C) 1995-2003, 2010 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* WARNING: this file should *not* be used by applications. It is
+   part of the implementation of the compression library and is
+   subject to change. Applications should only use zlib.h.
+ */
+
+/* Input bytes and output space needed to call inflate_fast9() */
+#define FAST9_IN 8
+#define FAST9_OUT 258
+
+extern void inflate_fast9(z_stream FAR *strm, unsigned start);
@@ -27,6 +27,15 @@
 
 
 #include "ioapi.h"
+#include <string.h>
+
+#if defined(__unix__) || defined(__unix) || defined(__APPLE__)
+#  define IOAPI_MMAP
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
 
 voidpf call_zopen64 (const zlib_filefunc64_32_def* pfilefunc, const void*filename, int mode) {
     if (pfilefunc->zfile_func64.zopen64_file != NULL)
@@ -229,3 +238,306 @@ void fill_fopen64_filefunc(zlib_filefunc64_def* pzlib_filefunc_def) {
     pzlib_filefunc_def->zerror_file = ferror_file_func;
     pzlib_filefunc_def->opaque = NULL;
 }
+
+/* an open zipfile in memory */
+typedef struct
+{
+    zlib_memory* mem;           /* the memory */
+    ZPOS64_T pos;               /* current position */
+    int error;                  /* true if a write failed */
+} memory_stream;
+
+static voidpf ZCALLBACK memory64_file_func(voidpf opaque, const void* filename, int mode) {
+    zlib_memory* mem = (zlib_memory*)opaque;
+    memory_stream* stream;
+    (void)filename;
+    if (mem == NULL)
+        return NULL;
+    if (((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER) != ZLIB_FILEFUNC_MODE_READ) &&
+        (mode & ZLIB_FILEFUNC_MODE_CREATE))
+    {
+        /* writing a new zipfile: keep the allocation, if any */
+        if (mem->room == 0 && mem->base != NULL)
+            return NULL;
+        mem->size = 0;
+    }
+    stream = (memory_stream*)malloc(sizeof(memory_stream));
+    if (stream != NULL)
+    {
+        stream->mem = mem;
+        stream->pos = 0;
+        stream->error = 0;
+    }
+    return stream;
+}
+
+static uLong ZCALLBACK memory_read_file_func(voidpf opaque, voidpf stream, void* buf, uLong size) {
+    memory_stream* ms = (memory_stream*)stream;
+    (void)opaque;
+    if (ms->pos >= ms->mem->size)
+        return 0;
+    if (size > ms->mem->size - ms->pos)
+        size = (uLong)(ms->mem->size - ms->pos);
+    memcpy(buf, ms->mem->base + ms->pos, (size_t)size);
+    ms->pos += size;
+    return size;
+}
+
+static uLong ZCALLBACK memory_write_file_func(voidpf opaque, voidpf stream, const void* buf, uLong size) {
+    memory_stream* ms = (memory_stream*)stream;
+    zlib_memory* mem = ms->mem;
+    (void)opaque;
+    if (mem->room < ms->pos || size > mem->room - ms->pos)
+    {
+        /* grow the buffer, if it's ours to grow */
+        ZPOS64_T room = mem->room == 0 ? 65536 : mem->room;
+        char* base;
+        if (mem->room == 0 && mem->base != NULL)
+        {
+            ms->error = 1;
+            return 0;
+        }
+        while (room < ms->pos + size)
+            room <<= 1;
+        base = (ZPOS64_T)(size_t)room != room ? NULL :
+               (char*)realloc(mem->base, (size_t)room);
+        if (base == NULL)
+        {
+            ms->error = 1;
+            return 0;
+        }
+        mem->base = base;
+        mem->room = room;
+    }
+    memcpy(mem->base + ms->pos, buf, (size_t)size);
+    ms->pos += size;
+    if (mem->size < ms->pos)
+        mem->size = ms->pos;
+    return size;
+}
+
+static ZPOS64_T ZCALLBACK memory_tell64_file_func(voidpf opaque, voidpf stream) {
+    (void)opaque;
+    return ((memory_stream*)stream)->pos;
+}
+
+static long ZCALLBACK memory_seek64_file_func(voidpf opaque, voidpf stream, ZPOS64_T offset, int origin) {
+    memory_stream* ms = (memory_stream*)stream;
+    ZPOS64_T base;
+    (void)opaque;
+    switch (origin)
+    {
+    case ZLIB_FILEFUNC_SEEK_CUR :
+        base = ms->pos;
+        break;
+    case ZLIB_FILEFUNC_SEEK_END :
+        base = ms->mem->size;
+        break;
+    case ZLIB_FILEFUNC_SEEK_SET :
+        base = 0;
+        break;
+    default: return -1;
+    }
+    if (base > ms->mem->size || offset > ms->mem->size - base)
+        return -1;
+    ms->pos = base + offset;
+    return 0;
+}
+
+static int ZCALLBACK memory_close_file_func(voidpf opaque, voidpf stream) {
+    (void)opaque;
+    free(stream);
+    return 0;
+}
+
+static int ZCALLBACK memory_error_file_func(voidpf opaque, voidpf stream) {
+    (void)opaque;
+    return ((memory_stream*)stream)->error;
+}
+
+void fill_memory_filefunc64(zlib_filefunc64_def* pzlib_filefunc_def, zlib_memory* mem) {
+    pzlib_filefunc_def->zopen64_file = memory64_file_func;
+    pzlib_filefunc_def->zread_file = memory_read_file_func;
+    pzlib_filefunc_def->zwrite_file = memory_write_file_func;
+    pzlib_filefunc_def->ztell64_file = memory_tell64_file_func;
+    pzlib_filefunc_def->zseek64_file = memory_seek64_file_func;
+    pzlib_filefunc_def->zclose_file = memory_close_file_func;
+    pzlib_filefunc_def->zerror_file = memory_error_file_func;
+    pzlib_filefunc_def->opaque = mem;
+}
+
+#ifdef IOAPI_MMAP
+
+/* a read-only mapping of a whole file, or the stdio stream for a file that
+   could not be mapped */
+typedef struct
+{
+    unsigned char* base;        /* the mapping, NULL if empty or not mapped */
+    ZPOS64_T size;              /* size of the file */
+    ZPOS64_T pos;               /* current position */
+    voidpf file;                /* fopen64_file_func() stream if not mapped */
+} mmap_stream;
+
+static voidpf ZCALLBACK mmap64_file_func(voidpf opaque, const void* filename, int mode) {
+    mmap_stream* map;
+    struct stat st;
+    int fd, mapped = 0;
+    if ((filename == NULL) ||
+        ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER) != ZLIB_FILEFUNC_MODE_READ))
+        return NULL;
+
+    map = (mmap_stream*)malloc(sizeof(mmap_stream));
+    if (map == NULL)
+        return NULL;
+    map->base = NULL;
+    map->size = 0;
+    map->pos = 0;
+    map->file = NULL;
+    fd = open((const char*)filename, O_RDONLY);
+    if (fd != -1)
+    {
+        if ((fstat(fd, &st) == 0) &&
+            ((ZPOS64_T)(size_t)st.st_size == (ZPOS64_T)st.st_size))
+        {
+            map->size = (ZPOS64_T)st.st_size;
+            if (map->size == 0)
+                mapped = 1;
+            else
+            {
+                void* p = mmap(NULL, (size_t)map->size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED)
+                {
+                    map->base = (unsigned char*)p;
+                    mapped = 1;
+                }
+            }
+        }
+        close(fd);
+    }
+
+    /* read the file with stdio if it could not be mapped */
+    if (!mapped)
+    {
+        map->file = fopen64_file_func(opaque, filename, mode);
+        if (map->file == NULL)
+        {
+            free(map);
+            map = NULL;
+        }
+    }
+    return map;
+}
+
+static uLong ZCALLBACK mmap_read_file_func(voidpf opaque, voidpf stream, void* buf, uLong size) {
+    mmap_stream* map = (mmap_stream*)stream;
+    if (map->file != NULL)
+        return fread_file_func(opaque, map->file, buf, size);
+    if (map->pos >= map->size)
+        return 0;
+    if (size > map->size - map->pos)
+        size = (uLong)(map->size - map->pos);
+    memcpy(buf, map->base + map->pos, (size_t)size);
+    map->pos += size;
+    return size;
+}
+
+static uLong ZCALLBACK mmap_write_file_func(voidpf opaque, voidpf stream, const void* buf, uLong size) {
+    (void)opaque;
+    (void)stream;
+    (void)buf;
+    (void)size;
+    return 0;
+}
+
+static ZPOS64_T ZCALLBACK mmap_tell64_file_func(voidpf opaque, voidpf stream) {
+    mmap_stream* map = (mmap_stream*)stream;
+    if (map->file != NULL)
+        return ftell64_file_func(opaque, map->file);
+    return map->pos;
+}
+
+static long ZCALLBACK mmap_seek64_file_func(voidpf opaque, voidpf stream, ZPOS64_T offset, int origin) {
+    mmap_stream* map = (mmap_stream*)stream;
+    ZPOS64_T base;
+    if (map->file != NULL)
+        return fseek64_file_func(opaque, map->file, offset, origin);
+    switch (origin)
+    {
+    case ZLIB_FILEFUNC_SEEK_CUR :
+        base = map->pos;
+        break;
+    case ZLIB_FILEFUNC_SEEK_END :
+        base = map->size;
+        break;
+    case ZLIB_FILEFUNC_SEEK_SET :
+        base = 0;
+        break;
+    default: return -1;
+    }
+    if (offset > map->size - base)
+        return -1;
+    map->pos = base + offset;
+    return 0;
+}
+
+static int ZCALLBACK mmap_close_file_func(voidpf opaque, voidpf stream) {
+    mmap_stream* map = (mmap_stream*)stream;
+    int ret = 0;
+    if (map->file != NULL)
+        ret = fclose_file_func(opaque, map->file);
+    else if (map->base != NULL)
+        ret = munmap(map->base, (size_t)map->size);
+    free(map);
+    return ret;
+}
+
+static int ZCALLBACK mmap_error_file_func(voidpf opaque, voidpf stream) {
+    mmap_stream* map = (mmap_stream*)stream;
+    if (map->file != NULL)
+        return ferror_file_func(opaque, map->file);
+    return 0;
+}
+
+void fill_mmap_filefunc64(zlib_filefunc64_def* pzlib_filefunc_def) {
+    pzlib_filefunc_def->zopen64_file = mmap64_file_func;
+    pzlib_filefunc_def->zread_file = mmap_read_file_func;
+    pzlib_filefunc_def->zwrite_file = mmap_write_file_func;
+    pzlib_filefunc_def->ztell64_file = mmap_tell64_file_func;
+    pzlib_filefunc_def->zseek64_file = mmap_seek64_file_func;
+    pzlib_filefunc_def->zclose_file = mmap_close_file_func;
+    pzlib_filefunc_def->zerror_file = mmap_error_file_func;
+    pzlib_filefunc_def->opaque = NULL;
+}
+
+#else
+
+void fill_mmap_filefunc64(zlib_filefunc64_def* pzlib_filefunc_def) {
+    fill_fopen64_filefunc(pzlib_filefunc_def);
+}
+
+#endif
+
+const void* call_zmap64(const zlib_filefunc64_32_def* pfilefunc, voidpf filestream, ZPOS64_T offset, ZPOS64_T* avail) {
+    if (pfilefunc->zfile_func64.zread_file == memory_read_file_func)
+    {
+        zlib_memory* mem = ((memory_stream*)filestream)->mem;
+        if (offset < mem->size)
+        {
+            *avail = mem->size - offset;
+            return mem->base + offset;
+        }
+    }
+#ifdef IOAPI_MMAP
+    if (pfilefunc->zfile_func64.zread_file == mmap_read_file_func)
+    {
+        mmap_stream* map = (mmap_stream*)filestream;
+        if ((map->base != NULL) && (offset < map->size))
+        {
+            *avail = map->size - offset;
+            return map->base + offset;
+        }
+    }
+#endif
+    *avail = 0;
+    return NULL;
+}
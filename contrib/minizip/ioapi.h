@@ -176,6 +176,34 @@ typedef struct zlib_filefunc64_def_s
 void fill_fopen64_filefunc(zlib_filefunc64_def* pzlib_filefunc_def);
 void fill_fopen_filefunc(zlib_filefunc_def* pzlib_filefunc_def);
 
+/* Read-only file functions that map the whole file into memory. unzip.c
+   inflates directly from the mapping, without copying the compressed data
+   into a buffer first. A file that cannot be mapped, such as one too large
+   for the address space, is read with the fill_fopen64_filefunc() functions
+   instead. Where mmap() is not available, these are the same as those. The
+   file must not be truncated while it is mapped, since reading past its new
+   end raises SIGBUS. */
+void fill_mmap_filefunc64(zlib_filefunc64_def* pzlib_filefunc_def);
+
+/* A zipfile in memory, for fill_memory_filefunc64(). */
+typedef struct zlib_memory_s
+{
+    char*    base;              /* the zipfile */
+    ZPOS64_T size;              /* length of the zipfile */
+    ZPOS64_T room;              /* space allocated at base, or 0 if base is
+                                   not to be grown (or freed) by minizip */
+} zlib_memory;
+
+/* File functions for a zipfile in memory, described by mem. The file name
+   given to unzOpen2_64() or zipOpen2_64() is ignored. To read a zipfile,
+   set base and size to the zipfile and room to zero. To write a zipfile,
+   set all three to zero, or base to space from malloc() of room bytes, and
+   base is grown with realloc() as needed. After zipClose(), the zipfile is
+   the size bytes at base, which now belong to the caller to free(). More
+   than one stream can read mem at once, but only one can write it. unzip.c
+   inflates directly from the memory. */
+void fill_memory_filefunc64(zlib_filefunc64_def* pzlib_filefunc_def, zlib_memory* mem);
+
 /* now internal definition, only for zip.c and unzip.h */
 typedef struct zlib_filefunc64_32_def_s
 {
@@ -196,6 +224,7 @@ typedef struct zlib_filefunc64_32_def_s
 voidpf call_zopen64(const zlib_filefunc64_32_def* pfilefunc,const void*filename,int mode);
 long call_zseek64(const zlib_filefunc64_32_def* pfilefunc,voidpf filestream, ZPOS64_T offset, int origin);
 ZPOS64_T call_ztell64(const zlib_filefunc64_32_def* pfilefunc,voidpf filestream);
+const void* call_zmap64(const zlib_filefunc64_32_def* pfilefunc,voidpf filestream, ZPOS64_T offset, ZPOS64_T* avail);
 
 void fill_zlib_filefunc64_32_def_from_filefunc32(zlib_filefunc64_32_def* p_filefunc64_32,const zlib_filefunc_def* p_filefunc32);
 
@@ -203,6 +232,10 @@ void fill_zlib_filefunc64_32_def_from_filefunc32(zlib_filefunc64_32_def* p_filef
 #define ZTELL64(filefunc,filestream)            (call_ztell64((&(filefunc)),(filestream)))
 #define ZSEEK64(filefunc,filestream,pos,mode)   (call_zseek64((&(filefunc)),(filestream),(pos),(mode)))
 
+/* Return a pointer to the data at pos in a stream that is mapped in memory,
+   with the number of bytes there in *avail, or NULL if it is not mapped. */
+#define ZMAP64(filefunc,filestream,pos,avail)   (call_zmap64((&(filefunc)),(filestream),(pos),(avail)))
+
 #ifdef __cplusplus
 }
 #endif
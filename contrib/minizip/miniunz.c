@@ -57,6 +57,7 @@
 
 
 #include "unzip.h"
+#include "unzpar.h"
 
 #define CASESENSITIVITY (0)
 #define WRITEBUFFERSIZE (8192)
@@ -187,14 +188,15 @@ static void do_banner(void) {
 }
 
 static void do_help(void) {
-    printf("Usage : miniunz [-e] [-x] [-v] [-l] [-o] [-p password] file.zip [file_to_extr.] [-d extractdir]\n\n" \
+    printf("Usage : miniunz [-e] [-x] [-v] [-l] [-o] [-p password] [-j threads] file.zip [file_to_extr.] [-d extractdir]\n\n" \
            "  -e  Extract without pathname (junk paths)\n" \
            "  -x  Extract with pathname\n" \
            "  -v  list files\n" \
            "  -l  list files\n" \
            "  -d  directory to extract into\n" \
            "  -o  overwrite files without prompting\n" \
-           "  -p  extract encrypted file using password\n\n");
+           "  -p  extract encrypted file using password\n" \
+           "  -j  extract with this many threads, overwriting files\n\n");
 }
 
 static void Display64BitsSize(ZPOS64_T n, int size_char) {
@@ -272,6 +274,11 @@ static int do_list(unzFile uf) {
         {
               string_method="BZip2 ";
         }
+        else
+        if (file_info.compression_method==Z_DEFLATE64ED)
+        {
+              string_method="Defl64";
+        }
         else
             string_method="Unkn. ";
 
@@ -529,6 +536,8 @@ int main(int argc, char *argv[]) {
     int opt_do_extract_withoutpath=0;
     int opt_overwrite=0;
     int opt_extractdir=0;
+    int opt_threads=0;
+    zlib_filefunc64_def ffunc;
     const char *dirname=NULL;
     unzFile uf=NULL;
 
@@ -570,6 +579,11 @@ int main(int argc, char *argv[]) {
                         password=argv[i+1];
                         i++;
                     }
+                    if (((c=='j') || (c=='J')) && (i+1<argc))
+                    {
+                        opt_threads=atoi(argv[i+1]);
+                        i++;
+                    }
                 }
             }
             else
@@ -585,28 +599,20 @@ int main(int argc, char *argv[]) {
     if (zipfilename!=NULL)
     {
 
-#        ifdef USEWIN32IOAPI
-        zlib_filefunc64_def ffunc;
-#        endif
-
         strncpy(filename_try, zipfilename,MAXFILENAME-1);
         /* strncpy doesn't append the trailing NULL, of the string is too long. */
         filename_try[ MAXFILENAME ] = '\0';
 
 #        ifdef USEWIN32IOAPI
         fill_win32_filefunc64A(&ffunc);
-        uf = unzOpen2_64(zipfilename,&ffunc);
 #        else
-        uf = unzOpen64(zipfilename);
+        fill_mmap_filefunc64(&ffunc);
 #        endif
+        uf = unzOpen2_64(zipfilename,&ffunc);
         if (uf==NULL)
         {
             strcat(filename_try,".zip");
-#            ifdef USEWIN32IOAPI
             uf = unzOpen2_64(filename_try,&ffunc);
-#            else
-            uf = unzOpen64(filename_try);
-#            endif
         }
     }
 
@@ -616,6 +622,7 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     printf("%s opened\n",filename_try);
+    unzLoadCentralDir(uf);
 
     if (opt_do_list==1)
         ret_value = do_list(uf);
@@ -631,7 +638,18 @@ int main(int argc, char *argv[]) {
           exit(-1);
         }
 
-        if (filename_to_extract == NULL)
+        if (filename_to_extract == NULL && opt_threads > 0 &&
+            !opt_do_extract_withoutpath)
+        {
+            int err = unzExtractParallel(filename_try, &ffunc, password, NULL,
+                                         opt_threads, NULL, NULL);
+            if (err != UNZ_OK)
+            {
+                printf("error %d with zipfile in unzExtractParallel\n",err);
+                ret_value = 1;
+            }
+        }
+        else if (filename_to_extract == NULL)
             ret_value = do_extract(uf, opt_do_extract_withoutpath, opt_overwrite, password);
         else
             ret_value = do_extract_onefile(uf, filename_to_extract, opt_do_extract_withoutpath, opt_overwrite, password);
@@ -59,6 +59,7 @@
 #endif
 
 #include "zip.h"
+#include "zippar.h"
 
 #ifdef _WIN32
         #define USEWIN32IOAPI
@@ -163,13 +164,14 @@ static void do_banner(void) {
 }
 
 static void do_help(void) {
-    printf("Usage : minizip [-o] [-a] [-0 to -9] [-p password] [-j] file.zip [files_to_add]\n\n" \
+    printf("Usage : minizip [-o] [-a] [-0 to -9] [-p password] [-j] [-t threads] file.zip [files_to_add]\n\n" \
            "  -o  Overwrite existing file.zip\n" \
            "  -a  Append to existing file.zip\n" \
            "  -0  Store only\n" \
            "  -1  Compress faster\n" \
            "  -9  Compress better\n\n" \
-           "  -j  exclude path. store only the file name.\n\n");
+           "  -j  exclude path. store only the file name.\n" \
+           "  -t  compress with this many threads\n\n");
 }
 
 /* calculate the CRC32 of a file,
@@ -238,6 +240,7 @@ int main(int argc, char *argv[]) {
     int opt_overwrite=0;
     int opt_compress_level=Z_DEFAULT_COMPRESSION;
     int opt_exclude_path=0;
+    int opt_threads=0;
     int zipfilenamearg = 0;
     char filename_try[MAXFILENAME+16];
     int zipok;
@@ -278,6 +281,11 @@ int main(int argc, char *argv[]) {
                         password=argv[i+1];
                         i++;
                     }
+                    if (((c=='t') || (c=='T')) && (i+1<argc))
+                    {
+                        opt_threads=atoi(argv[i+1]);
+                        i++;
+                    }
                 }
             }
             else
@@ -356,6 +364,7 @@ int main(int argc, char *argv[]) {
     if (zipok==1)
     {
         zipFile zf;
+        zipParFile zp=NULL;
         int errclose;
 #        ifdef USEWIN32IOAPI
         zlib_filefunc64_def ffunc;
@@ -373,8 +382,25 @@ int main(int argc, char *argv[]) {
         else
             printf("creating %s\n",filename_try);
 
+        if ((zf != NULL) && (opt_threads > 1))
+        {
+            zp = zipParOpen(zf,opt_threads,password);
+            if (zp == NULL)
+            {
+                printf("error allocating memory\n");
+                err = ZIP_INTERNALERROR;
+            }
+        }
+
         for (i=zipfilenamearg+1;(i<argc) && (err==ZIP_OK);i++)
         {
+            if ((((*(argv[i]))=='-') || ((*(argv[i]))=='/')) &&
+                ((argv[i][1]=='t') || (argv[i][1]=='T')) &&
+                (strlen(argv[i]) == 2))
+            {
+                i++; /* skip the number of threads */
+                continue;
+            }
             if (!((((*(argv[i]))=='-') || ((*(argv[i]))=='/')) &&
                   ((argv[i][1]=='o') || (argv[i][1]=='O') ||
                    (argv[i][1]=='a') || (argv[i][1]=='A') ||
@@ -403,10 +429,11 @@ int main(int argc, char *argv[]) {
                                  (opt_compress_level != 0) ? Z_DEFLATED : 0,
                                  opt_compress_level);
 */
-                if ((password != NULL) && (err==ZIP_OK))
+                if ((password != NULL) && (err==ZIP_OK) && (zp==NULL))
                     err = getFileCrc(filenameinzip,buf,size_buf,&crcFile);
 
-                zip64 = isLargeFile(filenameinzip);
+                if (zp==NULL)
+                    zip64 = isLargeFile(filenameinzip);
 
                                                          /* The path name saved, should not include a leading slash. */
                /*if it did, windows/xp and dynazip couldn't read the zip file. */
@@ -434,6 +461,17 @@ int main(int argc, char *argv[]) {
                      }
                  }
 
+                 if (zp != NULL)
+                 {
+                     /* compressed and written by the threads, in order */
+                     err = zipParAddFile(zp,savefilenameinzip,&zi,
+                                         filenameinzip,opt_compress_level);
+                     if (err != ZIP_OK)
+                         printf("error in adding %s to the zipfile\n",
+                                filenameinzip);
+                     continue;
+                 }
+
                  /**/
                 err = zipOpenNewFileInZip3_64(zf,savefilenameinzip,&zi,
                                  NULL,0,NULL,0,NULL /* comment*/,
@@ -493,6 +531,16 @@ int main(int argc, char *argv[]) {
                 }
             }
         }
+        if (zp != NULL)
+        {
+            int errpar = zipParClose(zp);
+            if (errpar != ZIP_OK)
+            {
+                printf("error in writing the files in the zipfile\n");
+                if (err == ZIP_OK)
+                    err = errpar;
+            }
+        }
         errclose = zipClose(zf,NULL);
         if (errclose != ZIP_OK)
             printf("error in closing %s\n",filename_try);
@@ -10,6 +10,7 @@
 #include <string.h>
 #include "zlib.h"
 #include "unzip.h"
+#include "zip.h"
 
 #define READ_8(adr)  ((unsigned char)*(adr))
 #define READ_16(adr) ( READ_8(adr) | (READ_8(adr+1) << 8) )
@@ -283,3 +284,126 @@ extern int ZEXPORT unzRepair(const char* file, const char* fileOut, const char*
   }
   return err;
 }
+
+#define COPY_BUFSIZE 65536
+
+/* Remove the blocks with the given id from the extra field at extra, which
+   is *len bytes long, updating *len. A malformed end is left as is. */
+static void dropExtraBlocks(char* extra, int* len, unsigned id) {
+  int i = 0, j = 0;
+  while (i + 4 <= *len) {
+    int size = 4 + (int)READ_16(extra + i + 2);
+    if (i + size > *len)
+      break;
+    if ((unsigned)READ_16(extra + i) != id) {
+      memmove(extra + j, extra + i, (size_t)size);
+      j += size;
+    }
+    i += size;
+  }
+  memmove(extra + j, extra + i, (size_t)(*len - i));
+  *len = j + *len - i;
+}
+
+extern int ZEXPORT zipCopyEntryFrom(unzFile uf, zipFile zf, const char* newname) {
+  unz_file_info64 info;
+  zip_fileinfo zi;
+  char* name = NULL;
+  char* extra = NULL;
+  char* local = NULL;
+  char* comment = NULL;
+  char* buf = NULL;
+  int size_extra, size_local;
+  int method, level, zip64;
+  int err;
+
+  if (uf == NULL || zf == NULL)
+    return ZIP_PARAMERROR;
+  err = unzGetCurrentFileInfo64(uf, &info, NULL, 0, NULL, 0, NULL, 0);
+  if (err != UNZ_OK)
+    return err;
+
+  /* get the name, extra fields, and comment */
+  name = (char*)malloc(info.size_filename + 1);
+  extra = (char*)malloc(info.size_file_extra + 1);
+  comment = (char*)malloc(info.size_file_comment + 1);
+  buf = (char*)malloc(COPY_BUFSIZE);
+  if (name == NULL || extra == NULL || comment == NULL || buf == NULL)
+    err = ZIP_INTERNALERROR;
+  if (err == UNZ_OK)
+    err = unzGetCurrentFileInfo64(uf, NULL, name, info.size_filename + 1,
+                                  extra, info.size_file_extra,
+                                  comment, info.size_file_comment + 1);
+  if (err == UNZ_OK)
+    err = unzOpenCurrentFile2(uf, &method, &level, 1);
+  if (err == UNZ_OK) {
+    size_local = unzGetLocalExtrafield(uf, NULL, 0);
+    if (size_local < 0)
+      err = size_local;
+    else if ((local = (char*)malloc((unsigned)size_local + 1)) == NULL)
+      err = ZIP_INTERNALERROR;
+    else if (unzGetLocalExtrafield(uf, local, (unsigned)size_local) != size_local)
+      err = UNZ_ERRNO;
+    if (err != UNZ_OK)
+      unzCloseCurrentFile(uf);
+  }
+
+  if (err == UNZ_OK) {
+    /* zip.c writes its own Zip64 extra fields as needed */
+    size_extra = (int)info.size_file_extra;
+    dropExtraBlocks(extra, &size_extra, 0x0001);
+    dropExtraBlocks(local, &size_local, 0x0001);
+
+    zi.tmz_date.tm_sec = info.tmu_date.tm_sec;
+    zi.tmz_date.tm_min = info.tmu_date.tm_min;
+    zi.tmz_date.tm_hour = info.tmu_date.tm_hour;
+    zi.tmz_date.tm_mday = info.tmu_date.tm_mday;
+    zi.tmz_date.tm_mon = info.tmu_date.tm_mon;
+    zi.tmz_date.tm_year = info.tmu_date.tm_year;
+    zi.dosDate = info.dosDate;
+    zi.internal_fa = info.internal_fa;
+    zi.external_fa = info.external_fa;
+    zip64 = info.uncompressed_size >= 0xffffffff ||
+            info.compressed_size >= 0xffffffff;
+
+    /* the level is not given, so that the original flags are kept -- the
+       data descriptor flag is dropped, since zip.c sets it when writing a
+       stream, except for an encrypted file, whose password check depends on
+       it, and which zip.c refuses if the flag does not match the zipfile */
+    err = zipOpenNewFileInZip4_64(zf, newname != NULL ? newname : name, &zi,
+                                  local, (uInt)size_local,
+                                  extra, (uInt)size_extra,
+                                  info.size_file_comment ? comment : NULL,
+                                  (int)info.compression_method,
+                                  Z_DEFAULT_COMPRESSION, 1,
+                                  -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY,
+                                  NULL, 0, info.version,
+                                  info.flag & 1 ? info.flag : info.flag & ~8UL,
+                                  zip64);
+    if (err == ZIP_OK) {
+      int got;
+      while ((got = unzReadCurrentFile(uf, buf, COPY_BUFSIZE)) > 0) {
+        err = zipWriteInFileInZip(zf, buf, (unsigned)got);
+        if (err != ZIP_OK)
+          break;
+      }
+      if (got < 0 && err == ZIP_OK)
+        err = got;
+      if (err == ZIP_OK)
+        err = zipCloseFileInZipRaw64(zf, info.uncompressed_size, info.crc);
+      else
+        zipCloseFileInZipRaw64(zf, info.uncompressed_size, info.crc);
+    }
+    if (err == ZIP_OK)
+      err = unzCloseCurrentFile(uf);
+    else
+      unzCloseCurrentFile(uf);
+  }
+
+  free(buf);
+  free(comment);
+  free(local);
+  free(extra);
+  free(name);
+  return err;
+}
@@ -16,6 +16,7 @@ extern "C" {
 #endif
 
 #include "unzip.h"
+#include "zip.h"
 
 /* Repair a ZIP file (missing central directory)
    file: file to recover
@@ -28,6 +29,26 @@ extern int ZEXPORT unzRepair(const char* file,
                              uLong* nRecovered,
                              uLong* bytesRecovered);
 
+/* Copy the current file of uf to zf as is, without decompressing and
+   recompressing it. The compressed data, crc, sizes, method, flags, date,
+   attributes, extra fields, and comment are carried over. The copy is named
+   newname, or the same as the original if newname is NULL. This can be used
+   to remove, rename, or merge entries quickly by copying the entries to keep
+   to a new zipfile. An encrypted file is copied still encrypted, with no
+   password needed. Since its password check depends on whether it has a data
+   descriptor, one with a data descriptor can only be copied to a zipfile
+   opened with APPEND_STATUS_STREAM, and one without only to a zipfile that
+   was not.
+
+   return value :
+   ZIP_OK if the file was copied
+   ZIP_PARAMERROR if it cannot be copied
+   otherwise an error from reading uf or writing zf
+*/
+extern int ZEXPORT zipCopyEntryFrom(unzFile uf,
+                                    zipFile zf,
+                                    const char* newname);
+
 
 #ifdef __cplusplus
 }
@@ -67,10 +67,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "zlib.h"
 #include "unzip.h"
 
+#ifdef HAVE_DEFLATE64
+#  include "infback9.h"
+#endif
+
 #ifdef STDC
 #  include <stddef.h>
 #endif
@@ -151,6 +156,37 @@ typedef struct
 } file_in_zip64_read_info_s;
 
 
+/* unz_name_entry and unz_name_index make up the index of the file names in
+    the zipfile built by unzIndexNames, for unzLocateFile */
+typedef struct
+{
+    ZPOS64_T pos_in_central_dir;    /* position of the file in the central dir*/
+    ZPOS64_T num_file;              /* number of the file in the zipfile */
+    uLong hash;                     /* hash of the name, ignoring case */
+    size_t name;                    /* offset of the name in names */
+} unz_name_entry;
+
+typedef struct
+{
+    unz_name_entry* entry;          /* the files, in central directory order */
+    ZPOS64_T count;                 /* number of files */
+    uLong* slot;                    /* hash table of entry number + 1, or 0 */
+    uLong mask;                     /* number of slots - 1 */
+    char* names;                    /* the file names, each terminated by 0 */
+} unz_name_index;
+
+
+/* unz_mem_stream is the central directory loaded in memory by
+    unzLoadCentralDir, read through the ioapi functions below */
+typedef struct
+{
+    unsigned char* buf;             /* the central directory */
+    ZPOS64_T size;                  /* its size */
+    ZPOS64_T origin;                /* its position in the file */
+    ZPOS64_T pos;                   /* current position in buf */
+} unz_mem_stream;
+
+
 /* unz64_s contain internal information about the zipfile
 */
 typedef struct
@@ -177,6 +213,11 @@ typedef struct
 
     int isZip64;
 
+    unz_name_index* name_index;    /* index of the file names, or NULL */
+
+    unz_mem_stream* central_dir;   /* central directory in memory, or NULL */
+    zlib_filefunc64_32_def central_dir_func; /* functions to read it */
+
 #    ifndef NOUNCRYPT
     unsigned long keys[3];     /* keys defining the pseudo-random sequence */
     const z_crc_t* pcrc_32_tab;
@@ -653,6 +694,8 @@ local unzFile unzOpenInternal(const void *path,
     us.central_pos = central_pos;
     us.pfile_in_zip_read = NULL;
     us.encrypted = 0;
+    us.name_index = NULL;
+    us.central_dir = NULL;
 
 
     s=(unz64_s*)ALLOC(sizeof(unz64_s));
@@ -699,6 +742,16 @@ extern unzFile ZEXPORT unzOpen64(const void *path) {
     return unzOpenInternal(path, NULL, 1);
 }
 
+local void unz64local_FreeNameIndex(unz_name_index* index) {
+    if (index != NULL)
+    {
+        free(index->names);
+        free(index->slot);
+        free(index->entry);
+        free(index);
+    }
+}
+
 /*
   Close a ZipFile opened with unzOpen.
   If there is files inside the .Zip opened with unzOpenCurrentFile (see later),
@@ -713,6 +766,12 @@ extern int ZEXPORT unzClose(unzFile file) {
     if (s->pfile_in_zip_read!=NULL)
         unzCloseCurrentFile(file);
 
+    unz64local_FreeNameIndex(s->name_index);
+    if (s->central_dir != NULL)
+    {
+        free(s->central_dir->buf);
+        free(s->central_dir);
+    }
     ZCLOSE64(s->z_filefunc, s->filestream);
     free(s);
     return UNZ_OK;
@@ -757,6 +816,111 @@ local void unz64local_DosDateToTmuDate(ZPOS64_T ulDosDate, tm_unz* ptm) {
     ptm->tm_sec =  (int) (2*(ulDosDate&0x1f)) ;
 }
 
+/*
+  ioapi functions to read the central directory loaded in memory
+*/
+local uLong ZCALLBACK unz64local_mem_read(voidpf opaque, voidpf stream,
+                                          void* buf, uLong size) {
+    unz_mem_stream* mem = (unz_mem_stream*)stream;
+    (void)opaque;
+    if (mem->pos >= mem->size)
+        return 0;
+    if (size > mem->size - mem->pos)
+        size = (uLong)(mem->size - mem->pos);
+    memcpy(buf, mem->buf + mem->pos, size);
+    mem->pos += size;
+    return size;
+}
+
+local ZPOS64_T ZCALLBACK unz64local_mem_tell(voidpf opaque, voidpf stream) {
+    (void)opaque;
+    return ((unz_mem_stream*)stream)->origin + ((unz_mem_stream*)stream)->pos;
+}
+
+local long ZCALLBACK unz64local_mem_seek(voidpf opaque, voidpf stream,
+                                         ZPOS64_T offset, int origin) {
+    unz_mem_stream* mem = (unz_mem_stream*)stream;
+    (void)opaque;
+    switch (origin)
+    {
+    case ZLIB_FILEFUNC_SEEK_SET :
+        if (offset < mem->origin)
+            return -1;
+        mem->pos = offset - mem->origin;
+        return 0;
+    case ZLIB_FILEFUNC_SEEK_CUR :
+        mem->pos += offset;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+local int ZCALLBACK unz64local_mem_error(voidpf opaque, voidpf stream) {
+    (void)opaque;
+    (void)stream;
+    return 0;
+}
+
+extern int ZEXPORT unzLoadCentralDir(unzFile file) {
+    unz64_s* s;
+    unz_mem_stream* mem;
+    ZPOS64_T got;
+
+    if (file==NULL)
+        return UNZ_PARAMERROR;
+    s=(unz64_s*)file;
+    if (s->central_dir != NULL)
+        return UNZ_OK;
+    if ((size_t)s->size_central_dir != s->size_central_dir)
+        return UNZ_INTERNALERROR;
+    mem = (unz_mem_stream*)ALLOC(sizeof(unz_mem_stream));
+    if (mem == NULL)
+        return UNZ_INTERNALERROR;
+    mem->buf = (unsigned char*)ALLOC((size_t)s->size_central_dir + 1);
+    if (mem->buf == NULL)
+    {
+        free(mem);
+        return UNZ_INTERNALERROR;
+    }
+    mem->size = s->size_central_dir;
+    mem->origin = s->offset_central_dir + s->byte_before_the_zipfile;
+    mem->pos = 0;
+
+    /* read it all, in one read unless it is larger than a uLong can say */
+    if (ZSEEK64(s->z_filefunc, s->filestream, mem->origin,
+                ZLIB_FILEFUNC_SEEK_SET) != 0)
+        got = 0;
+    else
+        for (got = 0; got < mem->size; )
+        {
+            uLong want = (uLong)-1, n;
+            if (want > mem->size - got)
+                want = (uLong)(mem->size - got);
+            n = ZREAD64(s->z_filefunc, s->filestream, mem->buf + got, want);
+            if (n == 0)
+                break;
+            got += n;
+        }
+    if (got != mem->size)
+    {
+        free(mem->buf);
+        free(mem);
+        return UNZ_ERRNO;
+    }
+
+    s->central_dir_func = s->z_filefunc;
+    s->central_dir_func.zfile_func64.zread_file = unz64local_mem_read;
+    s->central_dir_func.zfile_func64.ztell64_file = unz64local_mem_tell;
+    s->central_dir_func.zfile_func64.zseek64_file = unz64local_mem_seek;
+    s->central_dir_func.zfile_func64.zerror_file = unz64local_mem_error;
+    s->central_dir_func.zfile_func64.opaque = NULL;
+    s->central_dir_func.ztell32_file = NULL;
+    s->central_dir_func.zseek32_file = NULL;
+    s->central_dir = mem;
+    return UNZ_OK;
+}
+
 /*
   Get Info about the current file in the zipfile, with internal only info
 */
@@ -777,11 +941,27 @@ local int unz64local_GetCurrentFileInfoInternal(unzFile file,
     uLong uMagic;
     long lSeek=0;
     uLong uL;
+    const zlib_filefunc64_32_def* pzf;
+    voidpf fs;
 
     if (file==NULL)
         return UNZ_PARAMERROR;
     s=(unz64_s*)file;
-    if (ZSEEK64(s->z_filefunc, s->filestream,
+
+    /* read from the central directory in memory if it was loaded */
+    if (s->central_dir != NULL &&
+        s->pos_in_central_dir >= s->offset_central_dir &&
+        s->pos_in_central_dir - s->offset_central_dir < s->size_central_dir)
+    {
+        pzf = &s->central_dir_func;
+        fs = (voidpf)s->central_dir;
+    }
+    else
+    {
+        pzf = &s->z_filefunc;
+        fs = s->filestream;
+    }
+    if (ZSEEK64(*pzf, fs,
               s->pos_in_central_dir+s->byte_before_the_zipfile,
               ZLIB_FILEFUNC_SEEK_SET)!=0)
         err=UNZ_ERRNO;
@@ -790,60 +970,60 @@ local int unz64local_GetCurrentFileInfoInternal(unzFile file,
     /* we check the magic */
     if (err==UNZ_OK)
     {
-        if (unz64local_getLong(&s->z_filefunc, s->filestream,&uMagic) != UNZ_OK)
+        if (unz64local_getLong(pzf, fs,&uMagic) != UNZ_OK)
             err=UNZ_ERRNO;
         else if (uMagic!=0x02014b50)
             err=UNZ_BADZIPFILE;
     }
 
-    if (unz64local_getShort(&s->z_filefunc, s->filestream,&file_info.version) != UNZ_OK)
+    if (unz64local_getShort(pzf, fs,&file_info.version) != UNZ_OK)
         err=UNZ_ERRNO;
 
-    if (unz64local_getShort(&s->z_filefunc, s->filestream,&file_info.version_needed) != UNZ_OK)
+    if (unz64local_getShort(pzf, fs,&file_info.version_needed) != UNZ_OK)
         err=UNZ_ERRNO;
 
-    if (unz64local_getShort(&s->z_filefunc, s->filestream,&file_info.flag) != UNZ_OK)
+    if (unz64local_getShort(pzf, fs,&file_info.flag) != UNZ_OK)
         err=UNZ_ERRNO;
 
-    if (unz64local_getShort(&s->z_filefunc, s->filestream,&file_info.compression_method) != UNZ_OK)
+    if (unz64local_getShort(pzf, fs,&file_info.compression_method) != UNZ_OK)
         err=UNZ_ERRNO;
 
-    if (unz64local_getLong(&s->z_filefunc, s->filestream,&file_info.dosDate) != UNZ_OK)
+    if (unz64local_getLong(pzf, fs,&file_info.dosDate) != UNZ_OK)
         err=UNZ_ERRNO;
 
     unz64local_DosDateToTmuDate(file_info.dosDate,&file_info.tmu_date);
 
-    if (unz64local_getLong(&s->z_filefunc, s->filestream,&file_info.crc) != UNZ_OK)
+    if (unz64local_getLong(pzf, fs,&file_info.crc) != UNZ_OK)
         err=UNZ_ERRNO;
 
-    if (unz64local_getLong(&s->z_filefunc, s->filestream,&uL) != UNZ_OK)
+    if (unz64local_getLong(pzf, fs,&uL) != UNZ_OK)
         err=UNZ_ERRNO;
     file_info.compressed_size = uL;
 
-    if (unz64local_getLong(&s->z_filefunc, s->filestream,&uL) != UNZ_OK)
+    if (unz64local_getLong(pzf, fs,&uL) != UNZ_OK)
         err=UNZ_ERRNO;
     file_info.uncompressed_size = uL;
 
-    if (unz64local_getShort(&s->z_filefunc, s->filestream,&file_info.size_filename) != UNZ_OK)
+    if (unz64local_getShort(pzf, fs,&file_info.size_filename) != UNZ_OK)
         err=UNZ_ERRNO;
 
-    if (unz64local_getShort(&s->z_filefunc, s->filestream,&file_info.size_file_extra) != UNZ_OK)
+    if (unz64local_getShort(pzf, fs,&file_info.size_file_extra) != UNZ_OK)
         err=UNZ_ERRNO;
 
-    if (unz64local_getShort(&s->z_filefunc, s->filestream,&file_info.size_file_comment) != UNZ_OK)
+    if (unz64local_getShort(pzf, fs,&file_info.size_file_comment) != UNZ_OK)
         err=UNZ_ERRNO;
 
-    if (unz64local_getShort(&s->z_filefunc, s->filestream,&file_info.disk_num_start) != UNZ_OK)
+    if (unz64local_getShort(pzf, fs,&file_info.disk_num_start) != UNZ_OK)
         err=UNZ_ERRNO;
 
-    if (unz64local_getShort(&s->z_filefunc, s->filestream,&file_info.internal_fa) != UNZ_OK)
+    if (unz64local_getShort(pzf, fs,&file_info.internal_fa) != UNZ_OK)
         err=UNZ_ERRNO;
 
-    if (unz64local_getLong(&s->z_filefunc, s->filestream,&file_info.external_fa) != UNZ_OK)
+    if (unz64local_getLong(pzf, fs,&file_info.external_fa) != UNZ_OK)
         err=UNZ_ERRNO;
 
                 // relative offset of local header
-    if (unz64local_getLong(&s->z_filefunc, s->filestream,&uL) != UNZ_OK)
+    if (unz64local_getLong(pzf, fs,&uL) != UNZ_OK)
         err=UNZ_ERRNO;
     file_info_internal.offset_curfile = uL;
 
@@ -860,7 +1040,7 @@ local int unz64local_GetCurrentFileInfoInternal(unzFile file,
             uSizeRead = fileNameBufferSize;
 
         if ((file_info.size_filename>0) && (fileNameBufferSize>0))
-            if (ZREAD64(s->z_filefunc, s->filestream,szFileName,uSizeRead)!=uSizeRead)
+            if (ZREAD64(*pzf, fs,szFileName,uSizeRead)!=uSizeRead)
                 err=UNZ_ERRNO;
         lSeek -= uSizeRead;
     }
@@ -876,14 +1056,14 @@ local int unz64local_GetCurrentFileInfoInternal(unzFile file,
 
         if (lSeek!=0)
         {
-            if (ZSEEK64(s->z_filefunc, s->filestream,(ZPOS64_T)lSeek,ZLIB_FILEFUNC_SEEK_CUR)==0)
+            if (ZSEEK64(*pzf, fs,(ZPOS64_T)lSeek,ZLIB_FILEFUNC_SEEK_CUR)==0)
                 lSeek=0;
             else
                 err=UNZ_ERRNO;
         }
 
         if ((file_info.size_file_extra>0) && (extraFieldBufferSize>0))
-            if (ZREAD64(s->z_filefunc, s->filestream,extraField,(uLong)uSizeRead)!=uSizeRead)
+            if (ZREAD64(*pzf, fs,extraField,(uLong)uSizeRead)!=uSizeRead)
                 err=UNZ_ERRNO;
 
         lSeek += file_info.size_file_extra - (uLong)uSizeRead;
@@ -901,7 +1081,7 @@ local int unz64local_GetCurrentFileInfoInternal(unzFile file,
 
         if (lSeek!=0)
         {
-            if (ZSEEK64(s->z_filefunc, s->filestream,(ZPOS64_T)lSeek,ZLIB_FILEFUNC_SEEK_CUR)==0)
+            if (ZSEEK64(*pzf, fs,(ZPOS64_T)lSeek,ZLIB_FILEFUNC_SEEK_CUR)==0)
                 lSeek=0;
             else
                 err=UNZ_ERRNO;
@@ -912,10 +1092,10 @@ local int unz64local_GetCurrentFileInfoInternal(unzFile file,
             uLong headerId;
                                                 uLong dataSize;
 
-            if (unz64local_getShort(&s->z_filefunc, s->filestream,&headerId) != UNZ_OK)
+            if (unz64local_getShort(pzf, fs,&headerId) != UNZ_OK)
                 err=UNZ_ERRNO;
 
-            if (unz64local_getShort(&s->z_filefunc, s->filestream,&dataSize) != UNZ_OK)
+            if (unz64local_getShort(pzf, fs,&dataSize) != UNZ_OK)
                 err=UNZ_ERRNO;
 
             /* ZIP64 extra fields */
@@ -923,34 +1103,34 @@ local int unz64local_GetCurrentFileInfoInternal(unzFile file,
             {
                 if(file_info.uncompressed_size == MAXU32)
                 {
-                    if (unz64local_getLong64(&s->z_filefunc, s->filestream,&file_info.uncompressed_size) != UNZ_OK)
+                    if (unz64local_getLong64(pzf, fs,&file_info.uncompressed_size) != UNZ_OK)
                         err=UNZ_ERRNO;
                 }
 
                 if(file_info.compressed_size == MAXU32)
                 {
-                    if (unz64local_getLong64(&s->z_filefunc, s->filestream,&file_info.compressed_size) != UNZ_OK)
+                    if (unz64local_getLong64(pzf, fs,&file_info.compressed_size) != UNZ_OK)
                         err=UNZ_ERRNO;
                 }
 
                 if(file_info_internal.offset_curfile == MAXU32)
                 {
                     /* Relative Header offset */
-                    if (unz64local_getLong64(&s->z_filefunc, s->filestream,&file_info_internal.offset_curfile) != UNZ_OK)
+                    if (unz64local_getLong64(pzf, fs,&file_info_internal.offset_curfile) != UNZ_OK)
                         err=UNZ_ERRNO;
                 }
 
                 if(file_info.disk_num_start == 0xffff)
                 {
                     /* Disk Start Number */
-                    if (unz64local_getLong(&s->z_filefunc, s->filestream,&file_info.disk_num_start) != UNZ_OK)
+                    if (unz64local_getLong(pzf, fs,&file_info.disk_num_start) != UNZ_OK)
                         err=UNZ_ERRNO;
                 }
 
             }
             else
             {
-                if (ZSEEK64(s->z_filefunc, s->filestream,dataSize,ZLIB_FILEFUNC_SEEK_CUR)!=0)
+                if (ZSEEK64(*pzf, fs,dataSize,ZLIB_FILEFUNC_SEEK_CUR)!=0)
                     err=UNZ_ERRNO;
             }
 
@@ -971,14 +1151,14 @@ local int unz64local_GetCurrentFileInfoInternal(unzFile file,
 
         if (lSeek!=0)
         {
-            if (ZSEEK64(s->z_filefunc, s->filestream,(ZPOS64_T)lSeek,ZLIB_FILEFUNC_SEEK_CUR)==0)
+            if (ZSEEK64(*pzf, fs,(ZPOS64_T)lSeek,ZLIB_FILEFUNC_SEEK_CUR)==0)
                 lSeek=0;
             else
                 err=UNZ_ERRNO;
         }
 
         if ((file_info.size_file_comment>0) && (commentBufferSize>0))
-            if (ZREAD64(s->z_filefunc, s->filestream,szComment,uSizeRead)!=uSizeRead)
+            if (ZREAD64(*pzf, fs,szComment,uSizeRead)!=uSizeRead)
                 err=UNZ_ERRNO;
         lSeek+=file_info.size_file_comment - uSizeRead;
     }
@@ -1098,6 +1278,173 @@ extern int ZEXPORT unzGoToNextFile(unzFile file) {
 }
 
 
+/*
+  Hash of a file name that is the same for names that differ only in the case
+  of ASCII letters, so that one index serves both kinds of comparison.
+*/
+local uLong unz64local_NameHash(const char* name) {
+    uLong hash = 0;
+    for (; *name != '\0'; name++)
+    {
+        char c = *name;
+        if ((c>='a') && (c<='z'))
+            c -= 0x20;
+        hash = (hash * 31 + (unsigned char)c) & 0xffffffff;
+    }
+    return hash;
+}
+
+/*
+  Look up szFileName in the name index, and make the first file in the central
+  directory with that name the current file.
+*/
+local int unz64local_LocateIndexed(unz64_s* s, const char *szFileName,
+                                   int iCaseSensitivity) {
+    unz_name_index* index = s->name_index;
+    uLong hash = unz64local_NameHash(szFileName);
+    uLong i = hash & index->mask;
+
+    while (index->slot[i] != 0)
+    {
+        unz_name_entry* entry = index->entry + (index->slot[i] - 1);
+        if (entry->hash == hash &&
+            unzStringFileNameCompare(index->names + entry->name,
+                                     szFileName, iCaseSensitivity) == 0)
+        {
+            unz64_file_pos file_pos;
+            file_pos.pos_in_zip_directory = entry->pos_in_central_dir;
+            file_pos.num_of_file = entry->num_file;
+            return unzGoToFilePos64((unzFile)s, &file_pos);
+        }
+        i = (i + 1) & index->mask;
+    }
+    return UNZ_END_OF_LIST_OF_FILE;
+}
+
+extern int ZEXPORT unzIndexNames(unzFile file) {
+    unz64_s* s;
+    unz_name_index* index;
+    unz_file_info64 cur_file_infoSaved;
+    unz_file_info64_internal cur_file_info_internalSaved;
+    ZPOS64_T num_fileSaved;
+    ZPOS64_T pos_in_central_dirSaved;
+    ZPOS64_T current_file_okSaved;
+    ZPOS64_T room;
+    size_t used = 0, size = 0;
+    uLong n;
+    int err;
+
+    if (file==NULL)
+        return UNZ_PARAMERROR;
+    s=(unz64_s*)file;
+    if (s->name_index != NULL)
+        return UNZ_OK;
+    index = (unz_name_index*)ALLOC(sizeof(unz_name_index));
+    if (index == NULL)
+        return UNZ_INTERNALERROR;
+    index->entry = NULL;
+    index->count = 0;
+    index->slot = NULL;
+    index->names = NULL;
+
+    /* Save the current state */
+    num_fileSaved = s->num_file;
+    pos_in_central_dirSaved = s->pos_in_central_dir;
+    cur_file_infoSaved = s->cur_file_info;
+    cur_file_info_internalSaved = s->cur_file_info_internal;
+    current_file_okSaved = s->current_file_ok;
+
+    /* read the names from the central directory, as unzLocateFile would */
+    room = s->gi.number_entry != 0 ? s->gi.number_entry : 1;
+    err = s->gi.number_entry != 0 ? unzGoToFirstFile(file) :
+                                    UNZ_END_OF_LIST_OF_FILE;
+    while (err == UNZ_OK)
+    {
+        char szCurrentFileName[UNZ_MAXFILENAMEINZIP+1];
+        size_t len;
+        err = unzGetCurrentFileInfo64(file,NULL,
+                                    szCurrentFileName,sizeof(szCurrentFileName)-1,
+                                    NULL,0,NULL,0);
+        if (err != UNZ_OK)
+            break;
+        szCurrentFileName[UNZ_MAXFILENAMEINZIP] = '\0';
+        len = strlen(szCurrentFileName) + 1;
+
+        if (index->entry == NULL || index->count == room)
+        {
+            unz_name_entry* more;
+            if (index->entry != NULL)
+                room <<= 1;
+            more = (unz_name_entry*)realloc(index->entry,
+                                    (size_t)room * sizeof(unz_name_entry));
+            if (more == NULL)
+            {
+                err = UNZ_INTERNALERROR;
+                break;
+            }
+            index->entry = more;
+        }
+        if (size - used < len)
+        {
+            char* more;
+            size = size == 0 ? (size_t)room * 16 : size << 1;
+            if (size < used + len)
+                size = used + len;
+            more = (char*)realloc(index->names, size);
+            if (more == NULL)
+            {
+                err = UNZ_INTERNALERROR;
+                break;
+            }
+            index->names = more;
+        }
+        memcpy(index->names + used, szCurrentFileName, len);
+        index->entry[index->count].pos_in_central_dir = s->pos_in_central_dir;
+        index->entry[index->count].num_file = s->num_file;
+        index->entry[index->count].hash = unz64local_NameHash(szCurrentFileName);
+        index->entry[index->count].name = used;
+        index->count++;
+        used += len;
+        err = unzGoToNextFile(file);
+    }
+    if (err == UNZ_END_OF_LIST_OF_FILE)
+        err = UNZ_OK;
+
+    /* fill a hash table of at least twice as many slots as files, in central
+       directory order, so that the first of duplicate names is found first */
+    if (err == UNZ_OK)
+    {
+        index->mask = 1;
+        while (index->mask < index->count * 2)
+            index->mask <<= 1;
+        index->slot = (uLong*)calloc(index->mask, sizeof(uLong));
+        index->mask--;
+        if (index->slot == NULL)
+            err = UNZ_INTERNALERROR;
+    }
+    if (err == UNZ_OK)
+        for (n = 0; n < index->count; n++)
+        {
+            uLong i = index->entry[n].hash & index->mask;
+            while (index->slot[i] != 0)
+                i = (i + 1) & index->mask;
+            index->slot[i] = n + 1;
+        }
+
+    /* Restore the state of the 'current file' */
+    s->num_file = num_fileSaved ;
+    s->pos_in_central_dir = pos_in_central_dirSaved ;
+    s->cur_file_info = cur_file_infoSaved;
+    s->cur_file_info_internal = cur_file_info_internalSaved;
+    s->current_file_ok = current_file_okSaved;
+
+    if (err != UNZ_OK)
+        unz64local_FreeNameIndex(index);
+    else
+        s->name_index = index;
+    return err;
+}
+
 /*
   Try locate the file szFileName in the zipfile.
   For the iCaseSensitivity signification, see unzStringFileNameCompare
@@ -1129,6 +1476,9 @@ extern int ZEXPORT unzLocateFile(unzFile file, const char *szFileName, int iCase
     if (!s->current_file_ok)
         return UNZ_END_OF_LIST_OF_FILE;
 
+    if (s->name_index != NULL)
+        return unz64local_LocateIndexed(s, szFileName, iCaseSensitivity);
+
     /* Save the current state */
     num_fileSaved = s->num_file;
     pos_in_central_dirSaved = s->pos_in_central_dir;
@@ -1293,6 +1643,9 @@ local int unz64local_CheckCurrentFileCoherencyHeader(unz64_s* s, uInt* piSizeVar
 /* #ifdef HAVE_BZIP2 */
                          (s->cur_file_info.compression_method!=Z_BZIP2ED) &&
 /* #endif */
+#ifdef HAVE_DEFLATE64
+                         (s->cur_file_info.compression_method!=Z_DEFLATE64ED) &&
+#endif
                          (s->cur_file_info.compression_method!=Z_DEFLATED))
         err=UNZ_BADZIPFILE;
 
@@ -1399,6 +1752,9 @@ extern int ZEXPORT unzOpenCurrentFile3(unzFile file, int* method,
 /* #ifdef HAVE_BZIP2 */
         (s->cur_file_info.compression_method!=Z_BZIP2ED) &&
 /* #endif */
+#ifdef HAVE_DEFLATE64
+        (s->cur_file_info.compression_method!=Z_DEFLATE64ED) &&
+#endif
         (s->cur_file_info.compression_method!=Z_DEFLATED))
 
         err=UNZ_BADZIPFILE;
@@ -1465,6 +1821,27 @@ extern int ZEXPORT unzOpenCurrentFile3(unzFile file, int* method,
          * size of both compressed and uncompressed data
          */
     }
+#ifdef HAVE_DEFLATE64
+    else if ((s->cur_file_info.compression_method==Z_DEFLATE64ED) && (!raw))
+    {
+      pfile_in_zip_read_info->stream.zalloc = (alloc_func)0;
+      pfile_in_zip_read_info->stream.zfree = (free_func)0;
+      pfile_in_zip_read_info->stream.opaque = (voidpf)0;
+      pfile_in_zip_read_info->stream.next_in = 0;
+      pfile_in_zip_read_info->stream.avail_in = 0;
+
+      /* inflate9() is the pull version of inflateBack9() from infback9 */
+      err=inflate9Init(&pfile_in_zip_read_info->stream);
+      if (err == Z_OK)
+        pfile_in_zip_read_info->stream_initialised=Z_DEFLATE64ED;
+      else
+      {
+        free(pfile_in_zip_read_info->read_buffer);
+        free(pfile_in_zip_read_info);
+        return err;
+      }
+    }
+#endif
     pfile_in_zip_read_info->rest_read_compressed =
             s->cur_file_info.compressed_size ;
     pfile_in_zip_read_info->rest_read_uncompressed =
@@ -1550,6 +1927,8 @@ extern int ZEXPORT unzReadCurrentFile(unzFile file, voidp buf, unsigned len) {
     uInt iRead = 0;
     unz64_s* s;
     file_in_zip64_read_info_s* pfile_in_zip_read_info;
+    const void* pMapped;
+    ZPOS64_T uMapped;
     if (file==NULL)
         return UNZ_PARAMERROR;
     s=(unz64_s*)file;
@@ -1582,6 +1961,30 @@ extern int ZEXPORT unzReadCurrentFile(unzFile file, voidp buf, unsigned len) {
 
     while (pfile_in_zip_read_info->stream.avail_out>0)
     {
+        if ((pfile_in_zip_read_info->stream.avail_in==0) &&
+            (pfile_in_zip_read_info->rest_read_compressed>0) &&
+            (!s->encrypted) &&
+            ((pMapped = ZMAP64(pfile_in_zip_read_info->z_filefunc,
+                               pfile_in_zip_read_info->filestream,
+                               pfile_in_zip_read_info->pos_in_zipfile +
+                                  pfile_in_zip_read_info->byte_before_the_zipfile,
+                               &uMapped)) != NULL))
+        {
+            /* the zipfile is mapped in memory: take the input from there */
+            uInt uReadThis = (uInt)-1;
+            if (pfile_in_zip_read_info->rest_read_compressed<uReadThis)
+                uReadThis = (uInt)pfile_in_zip_read_info->rest_read_compressed;
+            if (uMapped<uReadThis)
+                uReadThis = (uInt)uMapped;
+
+            pfile_in_zip_read_info->pos_in_zipfile += uReadThis;
+
+            pfile_in_zip_read_info->rest_read_compressed-=uReadThis;
+
+            pfile_in_zip_read_info->stream.next_in = (Bytef*)(uintptr_t)pMapped;
+            pfile_in_zip_read_info->stream.avail_in = uReadThis;
+        }
+
         if ((pfile_in_zip_read_info->stream.avail_in==0) &&
             (pfile_in_zip_read_info->rest_read_compressed>0))
         {
@@ -1626,7 +2029,7 @@ extern int ZEXPORT unzReadCurrentFile(unzFile file, voidp buf, unsigned len) {
 
         if ((pfile_in_zip_read_info->compression_method==0) || (pfile_in_zip_read_info->raw))
         {
-            uInt uDoCopy,i ;
+            uInt uDoCopy;
 
             if ((pfile_in_zip_read_info->stream.avail_in == 0) &&
                 (pfile_in_zip_read_info->rest_read_compressed == 0))
@@ -1638,15 +2041,16 @@ extern int ZEXPORT unzReadCurrentFile(unzFile file, voidp buf, unsigned len) {
             else
                 uDoCopy = pfile_in_zip_read_info->stream.avail_in ;
 
-            for (i=0;i<uDoCopy;i++)
-                *(pfile_in_zip_read_info->stream.next_out+i) =
-                        *(pfile_in_zip_read_info->stream.next_in+i);
+            memcpy(pfile_in_zip_read_info->stream.next_out,
+                   pfile_in_zip_read_info->stream.next_in, uDoCopy);
 
             pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uDoCopy;
 
-            pfile_in_zip_read_info->crc32 = crc32(pfile_in_zip_read_info->crc32,
-                                pfile_in_zip_read_info->stream.next_out,
-                                uDoCopy);
+            /* the crc is not checked for raw data */
+            if (!pfile_in_zip_read_info->raw)
+                pfile_in_zip_read_info->crc32 = crc32(pfile_in_zip_read_info->crc32,
+                                    pfile_in_zip_read_info->stream.next_out,
+                                    uDoCopy);
             pfile_in_zip_read_info->rest_read_uncompressed-=uDoCopy;
             pfile_in_zip_read_info->stream.avail_in -= uDoCopy;
             pfile_in_zip_read_info->stream.avail_out -= uDoCopy;
@@ -1714,6 +2118,11 @@ extern int ZEXPORT unzReadCurrentFile(unzFile file, voidp buf, unsigned len) {
                 (pfile_in_zip_read_info->rest_read_compressed == 0))
                 flush = Z_FINISH;
             */
+#ifdef HAVE_DEFLATE64
+            if (pfile_in_zip_read_info->compression_method==Z_DEFLATE64ED)
+                err=inflate9(&pfile_in_zip_read_info->stream,flush);
+            else
+#endif
             err=inflate(&pfile_in_zip_read_info->stream,flush);
 
             if ((err>=0) && (pfile_in_zip_read_info->stream.msg!=NULL))
@@ -1893,6 +2302,10 @@ extern int ZEXPORT unzCloseCurrentFile(unzFile file) {
     else if (pfile_in_zip_read_info->stream_initialised == Z_BZIP2ED)
         BZ2_bzDecompressEnd(&pfile_in_zip_read_info->bstream);
 #endif
+#ifdef HAVE_DEFLATE64
+    else if (pfile_in_zip_read_info->stream_initialised == Z_DEFLATE64ED)
+        inflate9End(&pfile_in_zip_read_info->stream);
+#endif
 
 
     pfile_in_zip_read_info->stream_initialised = 0;
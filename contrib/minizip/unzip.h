@@ -61,6 +61,10 @@ extern "C" {
 
 #define Z_BZIP2ED 12
 
+/* Deflate64 (method 9) is decoded if HAVE_DEFLATE64 is defined, which needs
+   inflate9.c and inftree9.c from contrib/infback9 */
+#define Z_DEFLATE64ED 9
+
 #if defined(STRICTUNZIP) || defined(STRICTZIPUNZIP)
 /* like the STRICT of WIN32, we define a pointer that cannot be converted
     from (void*) without cast */
@@ -226,6 +230,20 @@ extern int ZEXPORT unzGetGlobalComment(unzFile file,
 /***************************************************************************/
 /* Unzip package allow you browse the directory of the zipfile */
 
+extern int ZEXPORT unzLoadCentralDir(unzFile file);
+/*
+  Read the whole central directory of the zipfile into memory with one read,
+  so that unzGoToFirstFile, unzGoToNextFile, unzGoToFilePos, unzLocateFile,
+  and unzIndexNames get the information about the files from memory instead
+  of with many small reads of the zipfile. The memory, the size of the central
+  directory, is freed by unzClose.
+
+  return value :
+  UNZ_OK if the central directory is in memory
+  UNZ_INTERNALERROR if there was not enough memory
+  UNZ_ERRNO if the central directory could not be read
+*/
+
 extern int ZEXPORT unzGoToFirstFile(unzFile file);
 /*
   Set the current file of the zipfile to the first file.
@@ -251,6 +269,20 @@ extern int ZEXPORT unzLocateFile(unzFile file,
   UNZ_END_OF_LIST_OF_FILE if the file is not found
 */
 
+extern int ZEXPORT unzIndexNames(unzFile file);
+/*
+  Build an index of the names of the files in the zipfile, reading the central
+  directory once, so that unzLocateFile finds a file in constant time instead
+  of reading the central directory from the start for each search. This is
+  worthwhile for zipfiles with many files when more than a few are located.
+  The index is freed by unzClose. The current file is not changed.
+
+  return value :
+  UNZ_OK if the index was built, or was already there
+  UNZ_INTERNALERROR if there was not enough memory
+  or the error from reading the central directory
+*/
+
 
 /* ****************************************** */
 /* Ryan supplied functions */
@@ -0,0 +1,413 @@
+/*
+  Parallel extraction for Minizip
+  Version 1.0, 2024
+  License: Same as ZLIB (www.gzip.org)
+*/
+
+#if (!defined(_WIN32)) && (!defined(WIN32)) && (!defined(__APPLE__))
+        #ifndef __USE_FILE_OFFSET64
+                #define __USE_FILE_OFFSET64
+        #endif
+        #ifndef __USE_LARGEFILE64
+                #define __USE_LARGEFILE64
+        #endif
+        #ifndef _LARGEFILE64_SOURCE
+                #define _LARGEFILE64_SOURCE
+        #endif
+        #ifndef _FILE_OFFSET_BIT
+                #define _FILE_OFFSET_BIT 64
+        #endif
+#endif
+
+#if defined(__APPLE__) || defined(__HAIKU__) || defined(MINIZIP_FOPEN_NO_64)
+#define FOPEN_FUNC(filename, mode) fopen(filename, mode)
+#else
+#define FOPEN_FUNC(filename, mode) fopen64(filename, mode)
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+# include <direct.h>
+#else
+# include <unistd.h>
+# include <utime.h>
+# include <pthread.h>
+# define UNZPAR_THREADS
+#endif
+
+#include "unzpar.h"
+
+#ifndef local
+#  define local static
+#endif
+
+#define WRITEBUFFERSIZE (65536)
+
+/* a file to extract */
+typedef struct
+{
+    unz64_file_pos pos;         /* where it is in the central directory */
+    ZPOS64_T size;              /* uncompressed size */
+    time_t mtime;               /* modification time */
+    char* name;                 /* path to write to */
+} unzpar_job;
+
+/* the work shared by the threads */
+typedef struct
+{
+    const void* path;
+    zlib_filefunc64_def* pzlib_filefunc_def;
+    const char* password;
+    unzpar_job* job;
+    uLong count;                /* number of jobs */
+    uLong next;                 /* next job to take */
+    int err;                    /* first error, or UNZ_OK */
+#ifdef UNZPAR_THREADS
+    pthread_mutex_t lock;       /* protects next and err */
+#endif
+} unzpar_work;
+
+local int unzpar_mkdir(const char* dirname) {
+#ifdef _WIN32
+    return _mkdir(dirname);
+#elif defined(__unix__) || defined(__unix) || defined(__APPLE__)
+    return mkdir(dirname,0775);
+#else
+    (void)dirname;
+    return 0;
+#endif
+}
+
+/* create the directories in path, up to its last slash */
+local void unzpar_makedirs(char* path) {
+    char* p;
+    for (p = path + 1; *p != '\0'; p++)
+        if (*p == '/' || *p == '\\')
+        {
+            char hold = *p;
+            *p = '\0';
+            unzpar_mkdir(path);
+            *p = hold;
+        }
+}
+
+/* convert the date in the zipfile to a time, before starting the threads,
+   since mktime() is not necessarily thread-safe */
+local time_t unzpar_time(tm_unz tmu_date) {
+    struct tm newdate;
+    newdate.tm_sec = tmu_date.tm_sec;
+    newdate.tm_min = tmu_date.tm_min;
+    newdate.tm_hour = tmu_date.tm_hour;
+    newdate.tm_mday = tmu_date.tm_mday;
+    newdate.tm_mon = tmu_date.tm_mon;
+    if (tmu_date.tm_year > 1900)
+        newdate.tm_year = tmu_date.tm_year - 1900;
+    else
+        newdate.tm_year = tmu_date.tm_year;
+    newdate.tm_isdst = -1;
+    return mktime(&newdate);
+}
+
+local void unzpar_set_date(const char* filename, time_t mtime) {
+#if defined(__unix__) || defined(__unix) || defined(__APPLE__)
+    struct utimbuf ut;
+    ut.actime = ut.modtime = mtime;
+    utime(filename,&ut);
+#else
+    (void)filename;
+    (void)mtime;
+#endif
+}
+
+/* extract one file from uf, return UNZ_OK or an error */
+local int unzpar_extract(unzFile uf, const unzpar_job* job,
+                         const char* password, void* buf) {
+    FILE* fout;
+    int err;
+
+    err = unzGoToFilePos64(uf, &job->pos);
+    if (err == UNZ_OK)
+        err = unzOpenCurrentFilePassword(uf, password);
+    if (err != UNZ_OK)
+        return err;
+
+    fout = FOPEN_FUNC(job->name, "wb");
+    if (fout == NULL)
+    {
+        /* some zipfiles don't list the directories before the files */
+        unzpar_makedirs(job->name);
+        fout = FOPEN_FUNC(job->name, "wb");
+    }
+    if (fout == NULL)
+    {
+        unzCloseCurrentFile(uf);
+        return UNZ_ERRNO;
+    }
+#ifdef __linux__
+    /* reserving the space is only to reduce fragmentation -- if it fails, the
+       writes below still report a full disk or other error themselves */
+    if (job->size != 0)
+        (void)posix_fallocate(fileno(fout), 0, (off_t)job->size);
+#endif
+
+    do
+    {
+        err = unzReadCurrentFile(uf, buf, WRITEBUFFERSIZE);
+        if (err > 0 && fwrite(buf, (unsigned)err, 1, fout) != 1)
+            err = UNZ_ERRNO;
+    }
+    while (err > 0);
+    if (fclose(fout) != 0 && err == UNZ_OK)
+        err = UNZ_ERRNO;
+
+    if (err == UNZ_OK)
+    {
+        err = unzCloseCurrentFile(uf);
+        if (err == UNZ_OK)
+            unzpar_set_date(job->name, job->mtime);
+    }
+    else
+        unzCloseCurrentFile(uf); /* don't lose the error */
+    return err;
+}
+
+/* take jobs and do them until there are none left or there is an error */
+local void* unzpar_worker(void* arg) {
+    unzpar_work* work = (unzpar_work*)arg;
+    unzFile uf;
+    void* buf;
+    int err = UNZ_OK;
+
+    buf = malloc(WRITEBUFFERSIZE);
+    uf = unzOpen2_64(work->path, work->pzlib_filefunc_def);
+    if (buf == NULL)
+        err = UNZ_INTERNALERROR;
+    else if (uf == NULL)
+        err = UNZ_ERRNO;
+    for (;;)
+    {
+        uLong n;
+#ifdef UNZPAR_THREADS
+        pthread_mutex_lock(&work->lock);
+#endif
+        if (err != UNZ_OK && work->err == UNZ_OK)
+            work->err = err;
+        n = work->err == UNZ_OK ? work->next : work->count;
+        if (n < work->count)
+            work->next++;
+#ifdef UNZPAR_THREADS
+        pthread_mutex_unlock(&work->lock);
+#endif
+        if (n == work->count)
+            break;
+        err = unzpar_extract(uf, work->job + n, work->password, buf);
+    }
+    if (uf != NULL)
+        unzClose(uf);
+    free(buf);
+    return NULL;
+}
+
+/* order the jobs by name, and by position for the same name */
+local int unzpar_cmp_name(const void* a, const void* b) {
+    const unzpar_job* x = (const unzpar_job*)a;
+    const unzpar_job* y = (const unzpar_job*)b;
+    int cmp = strcmp(x->name, y->name);
+    if (cmp != 0)
+        return cmp;
+    return x->pos.num_of_file < y->pos.num_of_file ? -1 :
+           x->pos.num_of_file > y->pos.num_of_file ? 1 : 0;
+}
+
+/* order the jobs largest first, so that the threads finish together */
+local int unzpar_cmp(const void* a, const void* b) {
+    ZPOS64_T x = ((const unzpar_job*)a)->size;
+    ZPOS64_T y = ((const unzpar_job*)b)->size;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+/* return the name to write for the name in the zipfile, as miniunz does */
+local const char* unzpar_sanitize(const char* name) {
+    const char* p;
+    for (p = name; p[0] != '\0' && p[1] != '\0'; p++)
+        if (p[0] == '.' && p[1] == '.')
+            name = p;
+    while (name[0] == '/' || name[0] == '.')
+        name++;
+    return name;
+}
+
+extern int ZEXPORT unzExtractParallel(const void* path,
+                                      zlib_filefunc64_def* pzlib_filefunc_def,
+                                      const char* password,
+                                      const char* dest_dir,
+                                      int threads,
+                                      unz_filter_func filter,
+                                      voidpf opaque) {
+    unzpar_work work;
+    unzFile uf;
+    uLong room = 0, n;
+    size_t dirlen = dest_dir == NULL ? 0 : strlen(dest_dir);
+    int err;
+
+    uf = unzOpen2_64(path, pzlib_filefunc_def);
+    if (uf == NULL)
+        return UNZ_ERRNO;
+    unzLoadCentralDir(uf);
+
+    /* list the files to extract, and make the directories */
+    work.path = path;
+    work.pzlib_filefunc_def = pzlib_filefunc_def;
+    work.password = password;
+    work.job = NULL;
+    work.count = 0;
+    work.next = 0;
+    err = unzGoToFirstFile(uf);
+    while (err == UNZ_OK)
+    {
+        unz_file_info64 info;
+        char* name;
+        const char* write_name;
+        int is_dir;
+        size_t len;
+
+        err = unzGetCurrentFileInfo64(uf, &info, NULL, 0, NULL, 0, NULL, 0);
+        if (err != UNZ_OK)
+            break;
+        name = (char*)malloc(info.size_filename + 1);
+        if (name == NULL)
+        {
+            err = UNZ_INTERNALERROR;
+            break;
+        }
+        err = unzGetCurrentFileInfo64(uf, NULL, name, info.size_filename + 1,
+                                      NULL, 0, NULL, 0);
+        if (err != UNZ_OK || (filter != NULL && !filter(opaque, name, &info)))
+        {
+            free(name);
+            if (err == UNZ_OK)
+                err = unzGoToNextFile(uf);
+            continue;
+        }
+
+        /* put the name to write under dest_dir */
+        write_name = unzpar_sanitize(name);
+        len = strlen(write_name);
+        if (work.count == room)
+        {
+            unzpar_job* more;
+            room = room == 0 ? 256 : room << 1;
+            more = (unzpar_job*)realloc(work.job, room * sizeof(unzpar_job));
+            if (more == NULL)
+            {
+                free(name);
+                err = UNZ_INTERNALERROR;
+                break;
+            }
+            work.job = more;
+        }
+        work.job[work.count].name = (char*)malloc(dirlen + 1 + len + 1);
+        if (work.job[work.count].name == NULL)
+        {
+            free(name);
+            err = UNZ_INTERNALERROR;
+            break;
+        }
+        if (dirlen != 0)
+        {
+            memcpy(work.job[work.count].name, dest_dir, dirlen);
+            work.job[work.count].name[dirlen] = '/';
+            memcpy(work.job[work.count].name + dirlen + 1, write_name, len + 1);
+        }
+        else
+            memcpy(work.job[work.count].name, write_name, len + 1);
+        is_dir = len == 0 || write_name[len - 1] == '/' ||
+                 write_name[len - 1] == '\\';
+        free(name);
+
+        if (is_dir)
+        {
+            /* a directory */
+            if (len != 0)
+                unzpar_makedirs(work.job[work.count].name);
+            free(work.job[work.count].name);
+        }
+        else
+        {
+            unzGetFilePos64(uf, &work.job[work.count].pos);
+            work.job[work.count].size = info.uncompressed_size;
+            work.job[work.count].mtime = unzpar_time(info.tmu_date);
+            work.count++;
+        }
+        err = unzGoToNextFile(uf);
+    }
+    if (err == UNZ_END_OF_LIST_OF_FILE)
+        err = UNZ_OK;
+    unzClose(uf);
+
+    /* extract the files */
+    if (err == UNZ_OK && work.count != 0)
+    {
+        /* of files with the same name, extract only the last one, which is
+           what extracting them in order would leave */
+        qsort(work.job, work.count, sizeof(unzpar_job), unzpar_cmp_name);
+        room = 0;
+        for (n = 0; n < work.count; n++)
+            if (n + 1 < work.count &&
+                strcmp(work.job[n].name, work.job[n + 1].name) == 0)
+                free(work.job[n].name);
+            else
+                work.job[room++] = work.job[n];
+        work.count = room;
+
+        qsort(work.job, work.count, sizeof(unzpar_job), unzpar_cmp);
+        work.err = UNZ_OK;
+#ifdef UNZPAR_THREADS
+        if (threads < 1)
+            threads = 1;
+        if ((uLong)threads > work.count)
+            threads = (int)work.count;
+        if (threads > 1)
+        {
+            pthread_t* tid = (pthread_t*)malloc(threads * sizeof(pthread_t));
+            int k, started = 0;
+            pthread_mutex_init(&work.lock, NULL);
+            if (tid != NULL)
+                for (k = 0; k < threads; k++)
+                {
+                    if (pthread_create(tid + k, NULL, unzpar_worker, &work))
+                        break;
+                    started++;
+                }
+            if (started == 0)
+                unzpar_worker(&work);
+            for (k = 0; k < started; k++)
+                pthread_join(tid[k], NULL);
+            free(tid);
+            pthread_mutex_destroy(&work.lock);
+        }
+        else
+        {
+            pthread_mutex_init(&work.lock, NULL);
+            unzpar_worker(&work);
+            pthread_mutex_destroy(&work.lock);
+        }
+#else
+        (void)threads;
+        unzpar_worker(&work);
+#endif
+        err = work.err;
+    }
+
+    for (n = 0; n < work.count; n++)
+        free(work.job[n].name);
+    free(work.job);
+    return err;
+}
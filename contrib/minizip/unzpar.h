@@ -0,0 +1,57 @@
+/*
+  Parallel extraction for Minizip
+  Version 1.0, 2024
+  License: Same as ZLIB (www.gzip.org)
+*/
+
+#ifndef _unz_par_H
+#define _unz_par_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef _ZLIB_H
+#include "zlib.h"
+#endif
+
+#include "unzip.h"
+
+/* Filter for unzExtractParallel: return non-zero to extract the file */
+typedef int (*unz_filter_func)(voidpf opaque,
+                               const char* filename,
+                               const unz_file_info64* file_info);
+
+/* Extract the files in the zipfile at path into the directory dest_dir (or
+   the current directory if dest_dir is NULL), using up to threads threads.
+   Each thread opens the zipfile for itself with pzlib_filefunc_def (see
+   unzOpen2_64, NULL for the default functions), and extracts whole files,
+   the largest first, after locating them with unzGoToFilePos64. If filter is
+   not NULL, then only the files for which filter(opaque, name, info) returns
+   non-zero are extracted. Directories are created as needed, existing files
+   are overwritten, and the space for each file is reserved before it is
+   written where the system allows. File names are sanitized as by miniunz:
+   leading slashes and anything up to the last ".." are removed. password is
+   the password for encrypted files, or NULL. Without POSIX threads, the files
+   are extracted one at a time in the calling thread.
+
+   return value :
+   UNZ_OK if all of the selected files were extracted
+   otherwise the first error encountered, after which no more files are
+   started
+*/
+extern int ZEXPORT unzExtractParallel(const void* path,
+                                      zlib_filefunc64_def* pzlib_filefunc_def,
+                                      const char* password,
+                                      const char* dest_dir,
+                                      int threads,
+                                      unz_filter_func filter,
+                                      voidpf opaque);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -97,6 +97,7 @@ const char zip_copyright[] =" zip 1.01 Copyright 1998-2004 Gilles Vollant - http
 #define SIZEDATA_INDATABLOCK (4096-(4*4))
 
 #define LOCALHEADERMAGIC    (0x04034b50)
+#define DESCRIPTORHEADERMAGIC (0x08074b50)
 #define CENTRALHEADERMAGIC  (0x02014b50)
 #define ENDHEADERMAGIC      (0x06054b50)
 #define ZIP64ENDHEADERMAGIC      (0x6064b50)
@@ -183,6 +184,11 @@ typedef struct
     ZPOS64_T add_position_when_writing_offset;
     ZPOS64_T number_entry;
 
+    // Support for APPEND_STATUS_STREAM.
+    int stream;                 // true if writing without seeking
+    zlib_filefunc64_32_def stream_func; // functions given to zipOpen3()
+    ZPOS64_T stream_pos;        // number of bytes written
+
 #ifndef NO_ADDFILEINEXISTINGZIP
     char *globalcomment;
 #endif
@@ -1047,6 +1053,45 @@ local int LoadCentralDirectoryRecord(zip64_internal* pziinit) {
 
 
 /************************************************************/
+/* When streaming, the file functions are replaced by these, which count the
+   bytes written to provide the position, and which refuse to seek. The
+   opaque pointer is the zip64_internal. */
+local uLong ZCALLBACK zip64local_stream_read(voidpf opaque, voidpf stream, void* buf, uLong size) {
+    (void)opaque;
+    (void)stream;
+    (void)buf;
+    (void)size;
+    return 0;
+}
+
+local uLong ZCALLBACK zip64local_stream_write(voidpf opaque, voidpf stream, const void* buf, uLong size) {
+    zip64_internal* zi = (zip64_internal*)opaque;
+    uLong written = ZWRITE64(zi->stream_func, stream, buf, size);
+    zi->stream_pos += written;
+    return written;
+}
+
+local ZPOS64_T ZCALLBACK zip64local_stream_tell(voidpf opaque, voidpf stream) {
+    (void)stream;
+    return ((zip64_internal*)opaque)->stream_pos;
+}
+
+local long ZCALLBACK zip64local_stream_seek(voidpf opaque, voidpf stream, ZPOS64_T offset, int origin) {
+    (void)opaque;
+    (void)stream;
+    (void)offset;
+    (void)origin;
+    return -1;
+}
+
+local int ZCALLBACK zip64local_stream_close(voidpf opaque, voidpf stream) {
+    return ZCLOSE64(((zip64_internal*)opaque)->stream_func, stream);
+}
+
+local int ZCALLBACK zip64local_stream_error(voidpf opaque, voidpf stream) {
+    return ZERROR64(((zip64_internal*)opaque)->stream_func, stream);
+}
+
 extern zipFile ZEXPORT zipOpen3(const void *pathname, int append, zipcharpc* globalcomment, zlib_filefunc64_32_def* pzlib_filefunc64_32_def) {
     zip64_internal ziinit;
     zip64_internal* zi;
@@ -1061,6 +1106,8 @@ extern zipFile ZEXPORT zipOpen3(const void *pathname, int append, zipcharpc* glo
 
     ziinit.filestream = ZOPEN64(ziinit.z_filefunc,
                   pathname,
+                  (append == APPEND_STATUS_STREAM) ?
+                  (ZLIB_FILEFUNC_MODE_WRITE | ZLIB_FILEFUNC_MODE_CREATE) :
                   (append == APPEND_STATUS_CREATE) ?
                   (ZLIB_FILEFUNC_MODE_READ | ZLIB_FILEFUNC_MODE_WRITE | ZLIB_FILEFUNC_MODE_CREATE) :
                     (ZLIB_FILEFUNC_MODE_READ | ZLIB_FILEFUNC_MODE_WRITE | ZLIB_FILEFUNC_MODE_EXISTING));
@@ -1071,7 +1118,22 @@ extern zipFile ZEXPORT zipOpen3(const void *pathname, int append, zipcharpc* glo
     if (append == APPEND_STATUS_CREATEAFTER)
         ZSEEK64(ziinit.z_filefunc,ziinit.filestream,0,SEEK_END);
 
-    ziinit.begin_pos = ZTELL64(ziinit.z_filefunc,ziinit.filestream);
+    ziinit.stream = append == APPEND_STATUS_STREAM;
+    ziinit.stream_pos = 0;
+    if (ziinit.stream)
+    {
+        // the output may not be seekable, so keep track of the position
+        ziinit.stream_func = ziinit.z_filefunc;
+        ziinit.z_filefunc.zfile_func64.zread_file = zip64local_stream_read;
+        ziinit.z_filefunc.zfile_func64.zwrite_file = zip64local_stream_write;
+        ziinit.z_filefunc.zfile_func64.ztell64_file = zip64local_stream_tell;
+        ziinit.z_filefunc.zfile_func64.zseek64_file = zip64local_stream_seek;
+        ziinit.z_filefunc.zfile_func64.zclose_file = zip64local_stream_close;
+        ziinit.z_filefunc.zfile_func64.zerror_file = zip64local_stream_error;
+        ziinit.begin_pos = 0;
+    }
+    else
+        ziinit.begin_pos = ZTELL64(ziinit.z_filefunc,ziinit.filestream);
     ziinit.in_opened_file_inzip = 0;
     ziinit.ci.stream_initialised = 0;
     ziinit.number_entry = 0;
@@ -1084,7 +1146,10 @@ extern zipFile ZEXPORT zipOpen3(const void *pathname, int append, zipcharpc* glo
     zi = (zip64_internal*)ALLOC(sizeof(zip64_internal));
     if (zi==NULL)
     {
-        ZCLOSE64(ziinit.z_filefunc,ziinit.filestream);
+        if (ziinit.stream)
+            ZCLOSE64(ziinit.stream_func,ziinit.filestream);
+        else
+            ZCLOSE64(ziinit.z_filefunc,ziinit.filestream);
         return NULL;
     }
 
@@ -1114,6 +1179,8 @@ extern zipFile ZEXPORT zipOpen3(const void *pathname, int append, zipcharpc* glo
     else
     {
         *zi = ziinit;
+        if (zi->stream)
+            zi->z_filefunc.zfile_func64.opaque = zi;
         return (zipFile)zi;
     }
 }
@@ -1269,11 +1336,12 @@ extern int ZEXPORT zipOpenNewFileInZip4_64(zipFile file, const char* filename, c
     if (file == NULL)
         return ZIP_PARAMERROR;
 
+    /* raw data is written as is, so any method can be copied */
 #ifdef HAVE_BZIP2
-    if ((method!=0) && (method!=Z_DEFLATED) && (method!=Z_BZIP2ED))
+    if ((method!=0) && (method!=Z_DEFLATED) && (method!=Z_BZIP2ED) && (!raw))
       return ZIP_PARAMERROR;
 #else
-    if ((method!=0) && (method!=Z_DEFLATED))
+    if ((method!=0) && (method!=Z_DEFLATED) && (!raw))
       return ZIP_PARAMERROR;
 #endif
 
@@ -1290,6 +1358,13 @@ extern int ZEXPORT zipOpenNewFileInZip4_64(zipFile file, const char* filename, c
 
     zi = (zip64_internal*)file;
 
+    // The password check byte of raw encrypted data was made from the time if
+    // the file had a data descriptor (bit 3), or from the crc if not. The file
+    // can only be copied if it will have a data descriptor here exactly when
+    // it had one, which is when writing a stream.
+    if (raw && (flagBase & 1) && ((flagBase & 8) != 0) != (zi->stream != 0))
+        return ZIP_PARAMERROR;
+
     if (zi->in_opened_file_inzip == 1)
     {
         err = zipCloseFileInZip (file);
@@ -1318,6 +1393,12 @@ extern int ZEXPORT zipOpenNewFileInZip4_64(zipFile file, const char* filename, c
     }
 
     zi->ci.flag = flagBase;
+    if (zi->stream)
+    {
+      // the crc and sizes follow the data in a data descriptor
+      zi->ci.flag |= 8;
+      crcForCrypting = (zi->ci.dosDate & 0xffff) << 16;
+    }
     if ((level==8) || (level==9))
       zi->ci.flag |= 2;
     if (level==2)
@@ -1607,7 +1688,9 @@ extern int ZEXPORT zipWriteInFileInZip(zipFile file, const void* buf, unsigned i
     if (zi->in_opened_file_inzip == 0)
         return ZIP_PARAMERROR;
 
-    zi->ci.crc32 = crc32(zi->ci.crc32,buf,(uInt)len);
+    /* the crc of raw data is provided to zipCloseFileInZipRaw64() */
+    if (!zi->ci.raw)
+        zi->ci.crc32 = crc32(zi->ci.crc32,buf,(uInt)len);
 
 #ifdef HAVE_BZIP2
     if(zi->ci.method == Z_BZIP2ED && (!zi->ci.raw))
@@ -1672,15 +1755,13 @@ extern int ZEXPORT zipWriteInFileInZip(zipFile file, const void* buf, unsigned i
           }
           else
           {
-              uInt copy_this,i;
+              uInt copy_this;
               if (zi->ci.stream.avail_in < zi->ci.stream.avail_out)
                   copy_this = zi->ci.stream.avail_in;
               else
                   copy_this = zi->ci.stream.avail_out;
 
-              for (i = 0; i < copy_this; i++)
-                  *(((char*)zi->ci.stream.next_out)+i) =
-                      *(((const char*)zi->ci.stream.next_in)+i);
+              memcpy(zi->ci.stream.next_out, zi->ci.stream.next_in, copy_this);
               {
                   zi->ci.stream.avail_in -= copy_this;
                   zi->ci.stream.avail_out-= copy_this;
@@ -1888,7 +1969,31 @@ extern int ZEXPORT zipCloseFileInZipRaw64(zipFile file, ZPOS64_T uncompressed_si
 
     free(zi->ci.central_header);
 
-    if (err==ZIP_OK)
+    if ((err==ZIP_OK) && zi->stream)
+    {
+        // Write the data descriptor, with eight-byte sizes if the local
+        // header has a Zip64 extra field.
+        err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)DESCRIPTORHEADERMAGIC,4);
+        if (err==ZIP_OK)
+            err = zip64local_putValue(&zi->z_filefunc,zi->filestream,crc32,4);
+        if (zi->ci.zip64)
+        {
+          if (err==ZIP_OK)
+              err = zip64local_putValue(&zi->z_filefunc,zi->filestream,compressed_size,8);
+          if (err==ZIP_OK)
+              err = zip64local_putValue(&zi->z_filefunc,zi->filestream,uncompressed_size,8);
+        }
+        else if(uncompressed_size >= 0xffffffff || compressed_size >= 0xffffffff )
+          err = ZIP_BADZIPFILE; // Caller passed zip64 = 0, so no room for zip64 info -> fatal
+        else
+        {
+          if (err==ZIP_OK)
+              err = zip64local_putValue(&zi->z_filefunc,zi->filestream,compressed_size,4);
+          if (err==ZIP_OK)
+              err = zip64local_putValue(&zi->z_filefunc,zi->filestream,uncompressed_size,4);
+        }
+    }
+    else if (err==ZIP_OK)
     {
         // Update the LocalFileHeader with the new values.
 
@@ -112,6 +112,7 @@ typedef const char* zipcharpc;
 #define APPEND_STATUS_CREATE        (0)
 #define APPEND_STATUS_CREATEAFTER   (1)
 #define APPEND_STATUS_ADDINZIP      (2)
+#define APPEND_STATUS_STREAM        (3)
 
 extern zipFile ZEXPORT zipOpen(const char *pathname, int append);
 extern zipFile ZEXPORT zipOpen64(const void *pathname, int append);
@@ -124,6 +125,13 @@ extern zipFile ZEXPORT zipOpen64(const void *pathname, int append);
          (useful if the file contain a self extractor code)
      if the file pathname exist and append==APPEND_STATUS_ADDINZIP, we will
        add files in existing zip (be sure you don't add file that doesn't exist)
+     if append==APPEND_STATUS_STREAM, a new zipfile is written from start to
+       end without ever seeking or reading back, so that it can be written to
+       a pipe or a socket. The crc and sizes of each file are then written in
+       a data descriptor after the file's data, instead of in its local header.
+       A file that may reach 4 GB must be opened with zip64 set. The password
+       check of raw encrypted data depends on flag bit 3, so such data can be
+       written to a stream only with that bit set, and elsewhere only without.
      If the zipfile cannot be opened, the return value is NULL.
      Else, the return value is a zipFile Handle, usable with other function
        of this zip package.
@@ -0,0 +1,555 @@
+/*
+  Parallel compression for Minizip
+  Version 1.0, 2024
+  License: Same as ZLIB (www.gzip.org)
+*/
+
+#if (!defined(_WIN32)) && (!defined(WIN32)) && (!defined(__APPLE__))
+        #ifndef __USE_FILE_OFFSET64
+                #define __USE_FILE_OFFSET64
+        #endif
+        #ifndef __USE_LARGEFILE64
+                #define __USE_LARGEFILE64
+        #endif
+        #ifndef _LARGEFILE64_SOURCE
+                #define _LARGEFILE64_SOURCE
+        #endif
+        #ifndef _FILE_OFFSET_BIT
+                #define _FILE_OFFSET_BIT 64
+        #endif
+#endif
+
+#if defined(__APPLE__) || defined(__HAIKU__) || defined(MINIZIP_FOPEN_NO_64)
+#define FOPEN_FUNC(filename, mode) fopen(filename, mode)
+#else
+#define FOPEN_FUNC(filename, mode) fopen64(filename, mode)
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+# include <pthread.h>
+# define ZIPPAR_THREADS
+#endif
+
+#include "zippar.h"
+
+#ifndef local
+#  define local static
+#endif
+
+#ifndef DEF_MEM_LEVEL
+#  if MAX_MEM_LEVEL >= 8
+#    define DEF_MEM_LEVEL 8
+#  else
+#    define DEF_MEM_LEVEL  MAX_MEM_LEVEL
+#  endif
+#endif
+
+#define BUFFERSIZE (65536)
+
+/* compressed data past this much for one entry goes to a temporary file */
+#define ZIPPAR_SPILL (1L << 20)
+
+/* the number of entries per thread that can be compressed ahead of the
+   entry being written, which bounds the memory used */
+#define ZIPPAR_AHEAD 4
+
+#ifdef ZIPPAR_THREADS
+#  define ZIPPAR_LOCK(zp) pthread_mutex_lock(&(zp)->lock)
+#  define ZIPPAR_UNLOCK(zp) pthread_mutex_unlock(&(zp)->lock)
+#  define ZIPPAR_SIGNAL(zp) pthread_cond_broadcast(&(zp)->cond)
+#else
+#  define ZIPPAR_LOCK(zp)
+#  define ZIPPAR_UNLOCK(zp)
+#  define ZIPPAR_SIGNAL(zp)
+#endif
+
+/* an entry to compress and write */
+typedef struct
+{
+    char* filename;             /* name in the zipfile */
+    zip_fileinfo zi;            /* copy of zipfi */
+    const zip_fileinfo* pzi;    /* &zi, or NULL */
+    const void* buf;            /* data to compress, or NULL */
+    ZPOS64_T len;               /* length of buf */
+    char* path;                 /* else the file to read it from */
+    int level;                  /* compression level, 0 to store */
+    int done;                   /* true when compressed */
+    int err;                    /* error compressing it, or ZIP_OK */
+    uLong crc;                  /* crc-32 of the uncompressed data */
+    ZPOS64_T size;              /* uncompressed size */
+    ZPOS64_T csize;             /* compressed size */
+    unsigned char* out;         /* the first of the compressed data */
+    size_t have;                /* amount of data at out */
+    size_t room;                /* allocated space at out */
+    FILE* spill;                /* the rest of the compressed data */
+} zippar_job;
+
+/* the state shared by the threads */
+typedef struct
+{
+    zipFile zf;
+    char* password;
+    zippar_job** job;           /* entries not yet written */
+    uLong count;                /* number of entries added */
+    uLong room;                 /* allocated space at job */
+    uLong next;                 /* next entry to compress */
+    uLong written;              /* number of entries written */
+    uLong ahead;                /* how far next can be past written */
+    int writing;                /* true if a thread is writing */
+    int closing;                /* true if no more entries will be added */
+    int err;                    /* first error, or ZIP_OK */
+    unsigned char* wbuf;        /* buffer for the writing thread */
+    unsigned char* in;          /* input buffer for the calling thread */
+    unsigned char* out;         /* output buffer for the calling thread */
+    int started;                /* number of threads running */
+#ifdef ZIPPAR_THREADS
+    pthread_t* tid;
+    pthread_mutex_t lock;       /* protects all of the above but zf */
+    pthread_cond_t cond;        /* signals an entry added or written */
+#endif
+} zippar_state;
+
+local void zippar_free(zippar_job* job) {
+    if (job->spill != NULL)
+        fclose(job->spill);
+    free(job->out);
+    free(job->path);
+    free(job->filename);
+    free(job);
+}
+
+/* append len bytes at data to the compressed data for job */
+local int zippar_put(zippar_job* job, const unsigned char* data, size_t len) {
+    job->csize += len;
+    if (job->have < ZIPPAR_SPILL)
+    {
+        size_t n = ZIPPAR_SPILL - job->have;
+        if (n > len)
+            n = len;
+        if (job->have + n > job->room)
+        {
+            unsigned char* more;
+            size_t room = job->room == 0 ? BUFFERSIZE : job->room << 1;
+            while (room < job->have + n)
+                room <<= 1;
+            if (room > ZIPPAR_SPILL)
+                room = ZIPPAR_SPILL;
+            more = (unsigned char*)realloc(job->out, room);
+            if (more == NULL)
+                return ZIP_INTERNALERROR;
+            job->out = more;
+            job->room = room;
+        }
+        memcpy(job->out + job->have, data, n);
+        job->have += n;
+        data += n;
+        len -= n;
+    }
+    if (len != 0)
+    {
+        if (job->spill == NULL)
+        {
+            job->spill = tmpfile();
+            if (job->spill == NULL)
+                return ZIP_ERRNO;
+        }
+        if (fwrite(data, len, 1, job->spill) != 1)
+            return ZIP_ERRNO;
+    }
+    return ZIP_OK;
+}
+
+/* compress the data for job, using the buffers in and out */
+local int zippar_compress(zippar_job* job, unsigned char* in,
+                          unsigned char* out) {
+    z_stream strm;
+    FILE* fin = NULL;
+    const unsigned char* next = (const unsigned char*)job->buf;
+    ZPOS64_T left = job->len;
+    int flush, err = ZIP_OK;
+
+    if (job->level != 0)
+    {
+        memset(&strm, 0, sizeof(strm));
+        if (deflateInit2(&strm, job->level, Z_DEFLATED, -MAX_WBITS,
+                         DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+            return ZIP_INTERNALERROR;
+    }
+    if (job->path != NULL)
+    {
+        fin = FOPEN_FUNC(job->path, "rb");
+        if (fin == NULL)
+            err = ZIP_ERRNO;
+    }
+
+    job->crc = crc32(0L, Z_NULL, 0);
+    if (err == ZIP_OK)
+        do
+        {
+            const unsigned char* data;
+            size_t got;
+            if (fin != NULL)
+            {
+                got = fread(in, 1, BUFFERSIZE, fin);
+                if (ferror(fin))
+                {
+                    err = ZIP_ERRNO;
+                    break;
+                }
+                data = in;
+                flush = got < BUFFERSIZE ? Z_FINISH : Z_NO_FLUSH;
+            }
+            else
+            {
+                got = left > BUFFERSIZE ? BUFFERSIZE : (size_t)left;
+                data = next;
+                next += got;
+                left -= got;
+                flush = left == 0 ? Z_FINISH : Z_NO_FLUSH;
+            }
+            job->crc = crc32_z(job->crc, data, got);
+            job->size += got;
+
+            if (job->level == 0)
+                err = zippar_put(job, data, got);
+            else
+            {
+                strm.next_in = (z_const Bytef*)data;
+                strm.avail_in = (uInt)got;
+                do
+                {
+                    strm.next_out = out;
+                    strm.avail_out = BUFFERSIZE;
+                    deflate(&strm, flush);
+                    err = zippar_put(job, out, BUFFERSIZE - strm.avail_out);
+                }
+                while (err == ZIP_OK && strm.avail_out == 0);
+            }
+        }
+        while (err == ZIP_OK && flush != Z_FINISH);
+
+    if (fin != NULL)
+        fclose(fin);
+    if (job->level != 0)
+    {
+        /* mark text as zipCloseFileInZip() does */
+        if (strm.data_type == Z_ASCII && job->pzi != NULL)
+            job->zi.internal_fa = Z_ASCII;
+        deflateEnd(&strm);
+    }
+    return err;
+}
+
+/* write the compressed entry job to the zipfile, using the buffer buf */
+local int zippar_write(zippar_state* zp, zippar_job* job,
+                       unsigned char* buf) {
+    int err, zip64;
+
+    zip64 = job->size >= 0xffffffff || job->csize >= 0xffffffff;
+    err = zipOpenNewFileInZip3_64(zp->zf, job->filename, job->pzi,
+                                  NULL, 0, NULL, 0, NULL,
+                                  job->level != 0 ? Z_DEFLATED : 0,
+                                  job->level, 1,
+                                  -MAX_WBITS, DEF_MEM_LEVEL,
+                                  Z_DEFAULT_STRATEGY,
+                                  zp->password, job->crc, zip64);
+    if (err != ZIP_OK)
+        return err;
+
+    if (job->have != 0)
+        err = zipWriteInFileInZip(zp->zf, job->out, (unsigned)job->have);
+    if (err == ZIP_OK && job->spill != NULL)
+    {
+        size_t got;
+        rewind(job->spill);
+        while (err == ZIP_OK &&
+               (got = fread(buf, 1, BUFFERSIZE, job->spill)) != 0)
+            err = zipWriteInFileInZip(zp->zf, buf, (unsigned)got);
+        if (err == ZIP_OK && ferror(job->spill))
+            err = ZIP_ERRNO;
+    }
+
+    if (err == ZIP_OK)
+        err = zipCloseFileInZipRaw64(zp->zf, job->size, job->crc);
+    else
+        zipCloseFileInZipRaw64(zp->zf, job->size, job->crc);
+    return err;
+}
+
+/* write the compressed entries that are next in order, unless another thread
+   is already doing that -- called with the lock held */
+local void zippar_drain(zippar_state* zp) {
+    if (zp->writing)
+        return;
+    zp->writing = 1;
+    while (zp->written < zp->count && zp->job[zp->written]->done)
+    {
+        zippar_job* job = zp->job[zp->written];
+        int err = zp->err;
+
+        ZIPPAR_UNLOCK(zp);
+        if (err == ZIP_OK)
+            err = job->err;
+        if (err == ZIP_OK)
+            err = zippar_write(zp, job, zp->wbuf);
+        zippar_free(job);
+        ZIPPAR_LOCK(zp);
+
+        zp->job[zp->written++] = NULL;
+        if (zp->err == ZIP_OK)
+            zp->err = err;
+        ZIPPAR_SIGNAL(zp);
+    }
+    zp->writing = 0;
+}
+
+#ifdef ZIPPAR_THREADS
+/* compress entries as they are added, until zipParClose() or an error */
+local void* zippar_worker(void* arg) {
+    zippar_state* zp = (zippar_state*)arg;
+    unsigned char* in;
+    unsigned char* out;
+
+    in = (unsigned char*)malloc(BUFFERSIZE);
+    out = (unsigned char*)malloc(BUFFERSIZE);
+    ZIPPAR_LOCK(zp);
+    if ((in == NULL || out == NULL) && zp->err == ZIP_OK)
+        zp->err = ZIP_INTERNALERROR;
+    for (;;)
+    {
+        zippar_job* job;
+        if (zp->err != ZIP_OK)
+            break;
+        if (zp->next == zp->count || zp->next >= zp->written + zp->ahead)
+        {
+            if (zp->closing && zp->next == zp->count)
+                break;
+            pthread_cond_wait(&zp->cond, &zp->lock);
+            continue;
+        }
+        job = zp->job[zp->next++];
+        ZIPPAR_UNLOCK(zp);
+        job->err = zippar_compress(job, in, out);
+        ZIPPAR_LOCK(zp);
+        job->done = 1;
+        zippar_drain(zp);
+    }
+    ZIPPAR_SIGNAL(zp);
+    ZIPPAR_UNLOCK(zp);
+    free(out);
+    free(in);
+    return NULL;
+}
+#endif
+
+extern zipParFile ZEXPORT zipParOpen(zipFile zf,
+                                     int threads,
+                                     const char* password) {
+    zippar_state* zp;
+
+    if (zf == NULL)
+        return NULL;
+    zp = (zippar_state*)malloc(sizeof(zippar_state));
+    if (zp == NULL)
+        return NULL;
+    memset(zp, 0, sizeof(zippar_state));
+    zp->zf = zf;
+    zp->err = ZIP_OK;
+    zp->wbuf = (unsigned char*)malloc(BUFFERSIZE);
+    zp->in = (unsigned char*)malloc(BUFFERSIZE);
+    zp->out = (unsigned char*)malloc(BUFFERSIZE);
+    if (password != NULL)
+    {
+        zp->password = (char*)malloc(strlen(password) + 1);
+        if (zp->password != NULL)
+            strcpy(zp->password, password);
+    }
+    if (zp->wbuf == NULL || zp->in == NULL || zp->out == NULL ||
+        (password != NULL && zp->password == NULL))
+    {
+        free(zp->password);
+        free(zp->out);
+        free(zp->in);
+        free(zp->wbuf);
+        free(zp);
+        return NULL;
+    }
+
+#ifdef ZIPPAR_THREADS
+    pthread_mutex_init(&zp->lock, NULL);
+    pthread_cond_init(&zp->cond, NULL);
+    if (threads > 1)
+    {
+        zp->ahead = (uLong)threads * ZIPPAR_AHEAD;
+        zp->tid = (pthread_t*)malloc(threads * sizeof(pthread_t));
+        if (zp->tid != NULL)
+            while (zp->started < threads &&
+                   pthread_create(zp->tid + zp->started, NULL,
+                                  zippar_worker, zp) == 0)
+                zp->started++;
+    }
+#else
+    (void)threads;
+#endif
+    return (zipParFile)zp;
+}
+
+/* add job to the entries, or compress and write it now if there are no
+   threads, freeing it on failure */
+local int zippar_add(zippar_state* zp, zippar_job* job) {
+    int err;
+
+    ZIPPAR_LOCK(zp);
+    err = zp->err;
+    if (err == ZIP_OK && zp->count == zp->room)
+    {
+        /* make room, growing the list if it's more than half full of
+           unwritten entries, and moving those to the front */
+        zippar_job** more = zp->job;
+        if (zp->written <= zp->room >> 1)
+        {
+            uLong room = zp->room == 0 ? 256 : zp->room << 1;
+            more = (zippar_job**)realloc(zp->job, room * sizeof(zippar_job*));
+            if (more != NULL)
+                zp->room = room;
+        }
+        if (more == NULL)
+            err = ZIP_INTERNALERROR;
+        else
+        {
+            zp->job = more;
+            if (zp->written != 0)
+                memmove(more, more + zp->written,
+                        (zp->count - zp->written) * sizeof(zippar_job*));
+            zp->count -= zp->written;
+            zp->next -= zp->written;
+            zp->written = 0;
+        }
+    }
+    if (err != ZIP_OK)
+    {
+        ZIPPAR_UNLOCK(zp);
+        zippar_free(job);
+        return err;
+    }
+    zp->job[zp->count++] = job;
+    ZIPPAR_SIGNAL(zp);
+
+    if (zp->started == 0)
+    {
+        /* no threads: do it now */
+        zp->next++;
+        ZIPPAR_UNLOCK(zp);
+        job->err = zippar_compress(job, zp->in, zp->out);
+        ZIPPAR_LOCK(zp);
+        job->done = 1;
+        zippar_drain(zp);
+        err = zp->err;
+    }
+    ZIPPAR_UNLOCK(zp);
+    return err;
+}
+
+/* return a new job for filename and zipfi, or NULL if out of memory */
+local zippar_job* zippar_job_new(const char* filename,
+                                 const zip_fileinfo* zipfi, int level) {
+    zippar_job* job;
+
+    job = (zippar_job*)malloc(sizeof(zippar_job));
+    if (job == NULL)
+        return NULL;
+    memset(job, 0, sizeof(zippar_job));
+    if (filename == NULL)
+        filename = "-";
+    job->filename = (char*)malloc(strlen(filename) + 1);
+    if (job->filename == NULL)
+    {
+        free(job);
+        return NULL;
+    }
+    strcpy(job->filename, filename);
+    if (zipfi != NULL)
+    {
+        job->zi = *zipfi;
+        job->pzi = &job->zi;
+    }
+    job->level = level;
+    job->err = ZIP_OK;
+    return job;
+}
+
+extern int ZEXPORT zipParAddBuffer(zipParFile zp,
+                                   const char* filename,
+                                   const zip_fileinfo* zipfi,
+                                   const void* buf,
+                                   ZPOS64_T len,
+                                   int level) {
+    zippar_job* job;
+
+    if (zp == NULL || (buf == NULL && len != 0))
+        return ZIP_PARAMERROR;
+    job = zippar_job_new(filename, zipfi, level);
+    if (job == NULL)
+        return ZIP_INTERNALERROR;
+    job->buf = buf;
+    job->len = len;
+    return zippar_add((zippar_state*)zp, job);
+}
+
+extern int ZEXPORT zipParAddFile(zipParFile zp,
+                                 const char* filename,
+                                 const zip_fileinfo* zipfi,
+                                 const char* path,
+                                 int level) {
+    zippar_job* job;
+
+    if (zp == NULL || path == NULL)
+        return ZIP_PARAMERROR;
+    job = zippar_job_new(filename, zipfi, level);
+    if (job == NULL)
+        return ZIP_INTERNALERROR;
+    job->path = (char*)malloc(strlen(path) + 1);
+    if (job->path == NULL)
+    {
+        zippar_free(job);
+        return ZIP_INTERNALERROR;
+    }
+    strcpy(job->path, path);
+    return zippar_add((zippar_state*)zp, job);
+}
+
+extern int ZEXPORT zipParClose(zipParFile file) {
+    zippar_state* zp = (zippar_state*)file;
+    uLong n;
+    int err;
+
+    if (zp == NULL)
+        return ZIP_PARAMERROR;
+#ifdef ZIPPAR_THREADS
+    ZIPPAR_LOCK(zp);
+    zp->closing = 1;
+    ZIPPAR_SIGNAL(zp);
+    ZIPPAR_UNLOCK(zp);
+    for (n = 0; n < (uLong)zp->started; n++)
+        pthread_join(zp->tid[n], NULL);
+    free(zp->tid);
+    pthread_cond_destroy(&zp->cond);
+    pthread_mutex_destroy(&zp->lock);
+#endif
+
+    /* free the entries left by an error */
+    for (n = zp->written; n < zp->count; n++)
+        zippar_free(zp->job[n]);
+    err = zp->err;
+    free(zp->job);
+    free(zp->password);
+    free(zp->out);
+    free(zp->in);
+    free(zp->wbuf);
+    free(zp);
+    return err;
+}
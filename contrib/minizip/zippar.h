@@ -0,0 +1,83 @@
+/*
+  Parallel compression for Minizip
+  Version 1.0, 2024
+  License: Same as ZLIB (www.gzip.org)
+*/
+
+#ifndef _zip_par_H
+#define _zip_par_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef _ZLIB_H
+#include "zlib.h"
+#endif
+
+#include "zip.h"
+
+typedef voidp zipParFile;
+
+/* Start adding entries to the zipfile zf, compressing them with up to
+   threads threads. The entries are compressed concurrently, each into memory
+   and, past a limit, into a temporary file, and are then written to zf one at
+   a time in the order they were added, as if by zipOpenNewFileInZip3_64(),
+   zipWriteInFileInZip(), and zipCloseFileInZipRaw64(). zf must not be used
+   otherwise until zipParClose() returns. If password is not NULL, then the
+   entries are encrypted with it. Without POSIX threads, or if threads is one
+   or less, each entry is compressed and written by the call that adds it.
+
+   return value :
+   a handle for zipParAddBuffer(), zipParAddFile(), and zipParClose()
+   NULL if out of memory
+*/
+extern zipParFile ZEXPORT zipParOpen(zipFile zf,
+                                     int threads,
+                                     const char* password);
+
+/* Add an entry named filename with the len bytes at buf, compressed at
+   level (0 to store it). zipfi is as for zipOpenNewFileInZip(), and is
+   copied. buf is not copied, and must not be changed or freed until
+   zipParClose() returns.
+
+   return value :
+   ZIP_OK if the entry was queued
+   otherwise the first error encountered for an earlier entry, or
+   ZIP_INTERNALERROR if out of memory
+*/
+extern int ZEXPORT zipParAddBuffer(zipParFile zp,
+                                   const char* filename,
+                                   const zip_fileinfo* zipfi,
+                                   const void* buf,
+                                   ZPOS64_T len,
+                                   int level);
+
+/* Add an entry named filename with the contents of the file at path,
+   compressed at level (0 to store it). The file is read when the entry is
+   compressed, and must be left alone until then. zipfi is as for
+   zipParAddBuffer(). The return value is as for zipParAddBuffer().
+*/
+extern int ZEXPORT zipParAddFile(zipParFile zp,
+                                 const char* filename,
+                                 const zip_fileinfo* zipfi,
+                                 const char* path,
+                                 int level);
+
+/* Wait for all of the entries to be written to the zipfile, and free zp.
+   The zipfile itself is left open, to be closed by zipClose().
+
+   return value :
+   ZIP_OK if all of the entries were written
+   otherwise the first error encountered, after which no more entries were
+   written
+*/
+extern int ZEXPORT zipParClose(zipParFile zp);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
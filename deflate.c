@@ -390,6 +390,15 @@ int ZEXPORT deflateInit2_(z_streamp strm, int level, int method,
     if (strm == Z_NULL) return Z_STREAM_ERROR;
 
     strm->msg = Z_NULL;
+    if (strm->zalloc == Z_POOL_ALLOC) {
+#ifdef Z_SOLO
+        return Z_STREAM_ERROR;
+#else
+        strm->zalloc = zpalloc;
+        strm->zfree = zpfree;
+        strm->opaque = (voidpf)0;
+#endif
+    }
     if (strm->zalloc == (alloc_func)0) {
 #ifdef Z_SOLO
         return Z_STREAM_ERROR;
@@ -523,6 +532,53 @@ int ZEXPORT deflateInit2_(z_streamp strm, int level, int method,
     return deflateReset(strm);
 }
 
+/* ========================================================================= */
+z_size_t ZEXPORT deflateWorkspaceSize(int level, int windowBits,
+                                      int memLevel) {
+    z_size_t w_size, lit_bufsize;
+
+#ifdef FASTEST
+    if (level != 0) level = 1;
+#else
+    if (level == Z_DEFAULT_COMPRESSION) level = 6;
+#endif
+    if (windowBits < 0)
+        windowBits = windowBits < -15 ? 0 : -windowBits;
+#ifdef GZIP
+    else if (windowBits > 15)
+        windowBits -= 16;
+#endif
+    if (memLevel < 1 || memLevel > MAX_MEM_LEVEL || windowBits < 8 ||
+        windowBits > 15 || level < 0 || level > 9)
+        return 0;
+    if (windowBits == 8) windowBits = 9;
+    w_size = (z_size_t)1 << windowBits;
+    lit_bufsize = (z_size_t)1 << (memLevel + 6);
+    return ZWORK_BASE + ZWORK_ROUND(sizeof(deflate_state)) +
+           ZWORK_ROUND(w_size * 2*sizeof(Byte)) +
+           ZWORK_ROUND(w_size * sizeof(Pos)) +
+           ZWORK_ROUND(((z_size_t)1 << (memLevel + 7)) * sizeof(Pos)) +
+           ZWORK_ROUND(lit_bufsize * LIT_BUFS);
+}
+
+/* ========================================================================= */
+int ZEXPORT deflateInitWorkspace_(z_streamp strm, int level, int method,
+                                  int windowBits, int memLevel, int strategy,
+                                  voidp work, z_size_t size,
+                                  const char *version, int stream_size) {
+    z_size_t need;
+
+    if (strm == Z_NULL) return Z_STREAM_ERROR;
+    need = deflateWorkspaceSize(level, windowBits, memLevel);
+    if (need != 0 && size < need) return Z_MEM_ERROR;
+    strm->opaque = zwinit(work, size);
+    if (strm->opaque == Z_NULL) return Z_MEM_ERROR;
+    strm->zalloc = zwalloc;
+    strm->zfree = zwfree;
+    return deflateInit2_(strm, level, method, windowBits, memLevel, strategy,
+                         version, stream_size);
+}
+
 /* =========================================================================
  * Check for a valid deflate stream state. Return 0 if ok, 1 if not.
  */
@@ -631,6 +687,91 @@ int ZEXPORT deflateGetDictionary(z_streamp strm, Bytef *dictionary,
     return Z_OK;
 }
 
+/* ========================================================================= */
+int ZEXPORT deflateMakeDictionary(z_streamp strm, const Bytef *dictionary,
+                                  uInt dictLength, z_dictp *dict) {
+    deflate_state *s;
+    z_dictp d;
+    int ret;
+
+    if (deflateStateCheck(strm) || dict == Z_NULL)
+        return Z_STREAM_ERROR;
+    s = strm->state;
+    if (s->strstart || s->lookahead)
+        return Z_STREAM_ERROR;
+
+    /* hash the dictionary as deflateSetDictionary() does, and save the result
+       in one allocation, with the tables first for alignment */
+    ret = deflateSetDictionary(strm, dictionary, dictLength);
+    if (ret != Z_OK)
+        return ret;
+    d = (z_dictp)ZALLOC(strm, 1, sizeof(struct z_dictionary_s) +
+                        (s->hash_size + s->strstart) * sizeof(Pos) +
+                        s->strstart);
+    if (d == Z_NULL) {
+        deflateReset(strm);
+        return Z_MEM_ERROR;
+    }
+    d->head = (ushf *)(d + 1);
+    d->prev = d->head + s->hash_size;
+    d->window = (Bytef *)(d->prev + s->strstart);
+    zmemcpy((Bytef *)d->head, (Bytef *)s->head, s->hash_size * sizeof(Pos));
+#ifndef FASTEST
+    zmemcpy((Bytef *)d->prev, (Bytef *)s->prev, s->strstart * sizeof(Pos));
+#endif
+    zmemcpy(d->window, s->window, s->strstart);
+    d->id = adler32(adler32(0L, Z_NULL, 0), dictionary, dictLength);
+    d->len = s->strstart;
+    d->w_bits = s->w_bits;
+    d->hash_bits = s->hash_bits;
+    d->hash_size = s->hash_size;
+    d->ins_h = s->ins_h;
+    d->insert = s->insert;
+    d->zfree = strm->zfree;
+    d->opaque = strm->opaque;
+    *dict = d;
+    return deflateReset(strm);
+}
+
+/* ========================================================================= */
+int ZEXPORT deflateUseDictionary(z_streamp strm, z_dictp dict) {
+    deflate_state *s;
+
+    if (deflateStateCheck(strm) || dict == Z_NULL)
+        return Z_STREAM_ERROR;
+    s = strm->state;
+    if (s->wrap == 2 || (s->wrap == 1 && s->status != INIT_STATE) ||
+        s->strstart || s->lookahead || dict->w_bits != s->w_bits ||
+        dict->hash_bits != s->hash_bits)
+        return Z_STREAM_ERROR;
+
+    /* copy in what deflateSetDictionary() would have computed */
+    if (s->wrap == 1)
+        strm->adler = dict->id;
+    zmemcpy(s->window, dict->window, dict->len);
+    zmemcpy((Bytef *)s->head, (Bytef *)dict->head,
+            s->hash_size * sizeof(Pos));
+#ifndef FASTEST
+    zmemcpy((Bytef *)s->prev, (Bytef *)dict->prev, dict->len * sizeof(Pos));
+#endif
+    strm->total_in += dict->len;
+    s->strstart = dict->len;
+    s->block_start = (long)s->strstart;
+    s->insert = dict->insert;
+    s->ins_h = dict->ins_h;
+    s->match_length = s->prev_length = MIN_MATCH-1;
+    s->match_available = 0;
+    return Z_OK;
+}
+
+/* ========================================================================= */
+int ZEXPORT deflateFreeDictionary(z_dictp dict) {
+    if (dict == Z_NULL)
+        return Z_STREAM_ERROR;
+    ZFREE(dict, dict);
+    return Z_OK;
+}
+
 /* ========================================================================= */
 int ZEXPORT deflateResetKeep(z_streamp strm) {
     deflate_state *s;
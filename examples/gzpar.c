@@ -0,0 +1,555 @@
+/* gzpar.c -- parallel reading of gzip files with multiple members
+ * Copyright (C) 2024 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ * Version 1.0  19 Oct 2026  Mark Adler */
+
+/* Version History:
+ 1.0  19 Oct 2026  First version
+ */
+
+// Read a gzip file like gzread(), but decompress its gzip members in parallel
+// when there is more than one. Each gzip member is independent of the others,
+// starting with an empty history and ending with its own CRC-32 and length.
+// So if the start of each member were known, they could all be decompressed
+// at once, and then delivered in order. The start of a member is only known
+// for sure once the member before it has been decompressed, since a member
+// doesn't say how long it is (with the exception of BGZF members). So the
+// compressed data is scanned ahead of the reader for the gzip header magic
+// bytes, and for each such candidate a worker thread tries to decompress a
+// gzip member from there. The reader uses a worker's output only if it
+// started exactly where the previous member ended. Candidates in the middle
+// of compressed data are most likely not valid gzip members at all, and if
+// they are, they are discarded when the member they are in ends past them.
+//
+// BGZF members have an extra field in the header with the length of the
+// member, so the scan can skip directly from one to the next. For other
+// files, the scan is a quick search for the magic bytes.
+//
+// A worker holds at most CAP bytes of a member's output. For a larger member,
+// or if there are no worker threads, or if a member start was not found by
+// the scan, the reader decompresses that member itself as it reads, just as
+// gzread() would. So a file with a single member, or a few large ones, is
+// read at the same speed as with gzread(), on one thread.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "zlib.h"
+#include "gzpar.h"
+
+#define CHUNK 65536         // input and output buffer size
+#define SCAN 1048576        // bytes scanned at a time for members
+#define AHEAD 4194304       // compressed bytes to scan ahead per worker
+#define CAP 16777216        // maximum output of a member held by a worker
+#define BGZF_HEAD 18        // length of a BGZF member header
+#define BIG 100             // member output exceeds CAP, not an error
+
+// States of a member job.
+#define QUEUED 0            // waiting for a worker
+#define RUNNING 1           // being decompressed by a worker
+#define DONE 2              // decompressed, or failed to be
+#define SKIP 3              // not needed
+
+// A candidate member start, and the result of decompressing it.
+typedef struct {
+    off_t start;            // file offset of the candidate
+    int state;              // QUEUED, RUNNING, DONE, or SKIP
+    int ret;                // Z_OK, BIG, or a zlib error code, once DONE
+    off_t end;              // file offset after the member, if Z_OK
+    unsigned char *out;     // decompressed member, if Z_OK
+    size_t len;             // length of decompressed member
+} job_t;
+
+// Reader state.
+struct gzpar_s {
+    int fd;                 // compressed file
+    off_t size;             // length of compressed file
+    int err;                // saved error, or Z_OK
+
+    // Candidate members, in order. The job with sequence number id is at
+    // jobs[id - base], as the finished prefix of jobs is discarded.
+    job_t *jobs;            // list of jobs
+    int have;               // number of jobs in the list
+    int room;               // allocated size of the list
+    long base;              // sequence number of jobs[0]
+    int first;              // first job the reader might use
+    int take;               // next job for a worker to consider
+    off_t scan;             // next offset to scan for candidates
+
+    // Threads.
+    int threads;            // number of worker threads started
+    pthread_t *pool;        // the worker threads
+    int quit;               // true to tell the workers to stop
+    pthread_mutex_t lock;   // protects the job list and quit
+    pthread_cond_t cond;    // signals job state changes and new jobs
+
+    // Output being delivered to the reader.
+    off_t expect;           // file offset of the next member
+    unsigned char *own;     // allocated output from a worker, or NULL
+    unsigned char *next;    // next output byte to deliver
+    size_t left;            // number of output bytes left at next
+
+    // Decompression by the reader.
+    int stream;             // true if decompressing a member here
+    off_t pos;              // file offset of the next input to read
+    z_stream strm;          // inflate engine for the reader
+    unsigned char in[CHUNK];    // input buffer
+    unsigned char buf[CHUNK];   // output buffer
+};
+
+// Read up to len bytes at offset pos in fd into buf. Return the number of
+// bytes read, which is less than len only at the end of the file, or -1 on
+// error.
+static ptrdiff_t load(int fd, unsigned char *buf, size_t len, off_t pos) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t ret = pread(fd, buf + got, len - got, pos + got);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret < 0)
+            return -1;
+        if (ret == 0)
+            break;
+        got += ret;
+    }
+    return got;
+}
+
+// Decompress one gzip member starting at start in fd. On success, return
+// Z_OK, with the output in *out and *len, and the offset after the member in
+// *end. Return BIG if the output would exceed CAP, or a zlib error code.
+static int member(int fd, off_t start, unsigned char **out, size_t *len,
+                  off_t *end) {
+    unsigned char *in = malloc(CHUNK);
+    z_stream strm;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.avail_in = 0;
+    strm.next_in = Z_NULL;
+    if (in == NULL || inflateInit2(&strm, 31) != Z_OK) {
+        free(in);
+        return Z_MEM_ERROR;
+    }
+    unsigned char *buf = NULL;
+    size_t size = 0, have = 0;
+    off_t pos = start;
+    int ret;
+    do {
+        if (strm.avail_in == 0) {
+            ptrdiff_t got = load(fd, in, CHUNK, pos);
+            if (got <= 0) {
+                ret = got < 0 ? Z_ERRNO : Z_BUF_ERROR;
+                break;
+            }
+            pos += got;
+            strm.avail_in = (unsigned)got;
+            strm.next_in = in;
+        }
+        if (have == size) {
+            if (size == CAP) {
+                ret = BIG;
+                break;
+            }
+            size = size ? size << 1 : CHUNK;
+            unsigned char *more = realloc(buf, size);
+            if (more == NULL) {
+                ret = Z_MEM_ERROR;
+                break;
+            }
+            buf = more;
+        }
+        strm.avail_out = (unsigned)(size - have);
+        strm.next_out = buf + have;
+        ret = inflate(&strm, Z_NO_FLUSH);
+        have = size - strm.avail_out;
+    } while (ret == Z_OK);
+    inflateEnd(&strm);
+    free(in);
+    if (ret == Z_STREAM_END) {
+        *out = buf;
+        *len = have;
+        *end = pos - strm.avail_in;
+        return Z_OK;
+    }
+    free(buf);
+    return ret == Z_NEED_DICT ? Z_DATA_ERROR : ret;
+}
+
+// Worker thread: decompress queued candidates in order until told to quit.
+static void *worker(void *arg) {
+    gzpar_t gz = arg;
+    pthread_mutex_lock(&gz->lock);
+    for (;;) {
+        while (!gz->quit && gz->take < gz->have &&
+               gz->jobs[gz->take].state != QUEUED)
+            gz->take++;
+        if (gz->quit)
+            break;
+        if (gz->take == gz->have) {
+            pthread_cond_wait(&gz->cond, &gz->lock);
+            continue;
+        }
+        long id = gz->base + gz->take++;
+        job_t *job = gz->jobs + (id - gz->base);
+        job->state = RUNNING;
+        off_t start = job->start;
+        pthread_mutex_unlock(&gz->lock);
+
+        unsigned char *out = NULL;
+        size_t len = 0;
+        off_t end = 0;
+        int ret = member(gz->fd, start, &out, &len, &end);
+
+        pthread_mutex_lock(&gz->lock);
+        job = gz->jobs + (id - gz->base);
+        job->ret = ret;
+        job->out = out;
+        job->len = len;
+        job->end = end;
+        job->state = DONE;
+        pthread_cond_broadcast(&gz->cond);
+    }
+    pthread_mutex_unlock(&gz->lock);
+    return NULL;
+}
+
+// Add a candidate member start at pos to the job list. Return 0 on success,
+// or -1 if out of memory.
+static int add(gzpar_t gz, off_t pos) {
+    pthread_mutex_lock(&gz->lock);
+    if (gz->have == gz->room) {
+        int room = gz->room ? gz->room << 1 : 64;
+        job_t *jobs = realloc(gz->jobs, room * sizeof(job_t));
+        if (jobs == NULL) {
+            pthread_mutex_unlock(&gz->lock);
+            return -1;
+        }
+        gz->jobs = jobs;
+        gz->room = room;
+    }
+    job_t *job = gz->jobs + gz->have++;
+    job->start = pos;
+    job->state = QUEUED;
+    job->out = NULL;
+    pthread_cond_broadcast(&gz->cond);
+    pthread_mutex_unlock(&gz->lock);
+    return 0;
+}
+
+// Return true if there is a plausible gzip header at p, with n bytes there. If
+// it is a BGZF header, set *next to the offset of the next member from p.
+static int header(const unsigned char *p, size_t n, off_t *next) {
+    *next = 0;
+    if (n < 4 || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8 || (p[3] & 0xe0))
+        return 0;
+    if (n >= BGZF_HEAD && p[3] == 4 && p[10] == 6 && p[11] == 0 &&
+        p[12] == 'B' && p[13] == 'C' && p[14] == 2 && p[15] == 0)
+        *next = (p[16] | (p[17] << 8)) + 1;
+    return 1;
+}
+
+// Scan ahead for candidate member starts. Either go directly to the next
+// member after a BGZF member, or search up to SCAN bytes for gzip headers.
+// Return 0 on success, or a zlib error code.
+static int scan(gzpar_t gz) {
+    unsigned char head[BGZF_HEAD];
+    ptrdiff_t got = load(gz->fd, head, BGZF_HEAD, gz->scan);
+    if (got < 0)
+        return Z_ERRNO;
+    off_t next;
+    if (header(head, got, &next) && next) {
+        if (add(gz, gz->scan))
+            return Z_MEM_ERROR;
+        gz->scan += next;
+        return Z_OK;
+    }
+
+    // Search a chunk, including enough after it to check a header that
+    // starts in the chunk.
+    unsigned char *buf = malloc(SCAN + BGZF_HEAD);
+    if (buf == NULL)
+        return Z_MEM_ERROR;
+    got = load(gz->fd, buf, SCAN + BGZF_HEAD, gz->scan);
+    if (got < 0) {
+        free(buf);
+        return Z_ERRNO;
+    }
+    size_t span = got > SCAN ? SCAN : (size_t)got;
+    unsigned char *p = buf, *end = buf + span;
+    while ((p = memchr(p, 0x1f, end - p)) != NULL) {
+        if (header(p, buf + got - p, &next)) {
+            if (add(gz, gz->scan + (p - buf))) {
+                free(buf);
+                return Z_MEM_ERROR;
+            }
+            if (next) {
+                // BGZF -- skip ahead to the next member.
+                gz->scan += (p - buf) + next;
+                free(buf);
+                return Z_OK;
+            }
+        }
+        p++;
+    }
+    gz->scan += span ? span : 1;
+    free(buf);
+    return Z_OK;
+}
+
+// Discard the jobs at the start of the list that are no longer needed, once
+// the workers are done with them.
+static void compact(gzpar_t gz) {
+    int n = 0;
+    while (n < gz->first && gz->jobs[n].state != RUNNING) {
+        free(gz->jobs[n].out);
+        gz->jobs[n].out = NULL;
+        n++;
+    }
+    if (n < 64 || n < gz->have >> 1)
+        return;
+    memmove(gz->jobs, gz->jobs + n, (gz->have - n) * sizeof(job_t));
+    gz->have -= n;
+    gz->first -= n;
+    gz->take = gz->take > n ? gz->take - n : 0;
+    gz->base += n;
+}
+
+// Start decompressing the member at gz->expect in this thread. Return 1 if
+// started, or 0 if there is no member there.
+static int stream(gzpar_t gz) {
+    unsigned char head[2];
+    if (load(gz->fd, head, 2, gz->expect) != 2 || head[0] != 0x1f ||
+        head[1] != 0x8b)
+        return 0;
+    inflateReset(&gz->strm);
+    gz->strm.avail_in = 0;
+    gz->pos = gz->expect;
+    gz->stream = 1;
+    return 1;
+}
+
+// Get the next member's output for delivery. Return 1 if there is output or a
+// member is being decompressed in this thread, 0 at the end of the members, or
+// a zlib error code.
+static int next(gzpar_t gz) {
+    if (gz->expect >= gz->size)
+        return 0;
+    if (gz->threads == 0)
+        return stream(gz) ? 1 : gz->expect ? 0 : Z_DATA_ERROR;
+
+    pthread_mutex_lock(&gz->lock);
+    for (;;) {
+        // Skip candidates in the middle of members already delivered.
+        while (gz->first < gz->have &&
+               gz->jobs[gz->first].start < gz->expect) {
+            if (gz->jobs[gz->first].state == QUEUED)
+                gz->jobs[gz->first].state = SKIP;
+            gz->first++;
+        }
+        compact(gz);
+
+        // Make sure the scan has looked at gz->expect, and keep enough
+        // candidates queued ahead of it to keep the workers busy, without
+        // scanning too far into what may be one large member.
+        if (gz->scan < gz->expect)
+            gz->scan = gz->expect;
+        if (gz->scan < gz->size &&
+            (gz->scan == gz->expect ||
+             (gz->have - gz->first < gz->threads << 1 &&
+              gz->scan - gz->expect < AHEAD * gz->threads))) {
+            pthread_mutex_unlock(&gz->lock);
+            int ret = scan(gz);
+            if (ret != Z_OK)
+                return ret;
+            pthread_mutex_lock(&gz->lock);
+            continue;
+        }
+        break;
+    }
+
+    // If the scan didn't find the next member, decompress it here.
+    if (gz->first == gz->have || gz->jobs[gz->first].start != gz->expect) {
+        pthread_mutex_unlock(&gz->lock);
+        return stream(gz) ? 1 : gz->expect ? 0 : Z_DATA_ERROR;
+    }
+
+    // Wait for the worker to finish the next member, and use it.
+    job_t *job = gz->jobs + gz->first;
+    if (job->state == QUEUED)
+        // Nothing is ahead of this one -- the workers will get to it first.
+        pthread_cond_broadcast(&gz->cond);
+    while (gz->jobs[gz->first].state != DONE)
+        pthread_cond_wait(&gz->cond, &gz->lock);
+    job = gz->jobs + gz->first++;
+    int ret = job->ret;
+    if (ret == Z_OK) {
+        gz->own = gz->next = job->out;
+        gz->left = job->len;
+        job->out = NULL;
+        gz->expect = job->end;
+    }
+    pthread_mutex_unlock(&gz->lock);
+    if (ret == BIG)
+        return stream(gz);
+    return ret == Z_OK ? 1 : ret;
+}
+
+// Decompress more of the member being decompressed in this thread into
+// gz->buf. Return 0 on success or a zlib error code.
+static int more(gzpar_t gz) {
+    z_stream *strm = &gz->strm;
+    strm->avail_out = CHUNK;
+    strm->next_out = gz->buf;
+    int ret;
+    do {
+        if (strm->avail_in == 0) {
+            ptrdiff_t got = load(gz->fd, gz->in, CHUNK, gz->pos);
+            if (got <= 0)
+                return got < 0 ? Z_ERRNO : Z_BUF_ERROR;
+            gz->pos += got;
+            strm->avail_in = (unsigned)got;
+            strm->next_in = gz->in;
+        }
+        ret = inflate(strm, Z_NO_FLUSH);
+    } while (ret == Z_OK && strm->avail_out);
+    if (ret != Z_OK && ret != Z_STREAM_END)
+        return ret == Z_NEED_DICT ? Z_DATA_ERROR : ret;
+    gz->next = gz->buf;
+    gz->left = CHUNK - strm->avail_out;
+    if (ret == Z_STREAM_END) {
+        gz->expect = gz->pos - strm->avail_in;
+        gz->stream = 0;
+    }
+    return Z_OK;
+}
+
+// See comments in gzpar.h.
+ptrdiff_t gzpar_read(gzpar_t gz, void *buf, size_t len) {
+    unsigned char *put = buf;
+    size_t got = 0;
+    while (got < len && gz->err == Z_OK) {
+        if (gz->left) {
+            size_t n = gz->left < len - got ? gz->left : len - got;
+            memcpy(put + got, gz->next, n);
+            gz->next += n;
+            gz->left -= n;
+            got += n;
+            continue;
+        }
+        free(gz->own);
+        gz->own = NULL;
+        int ret;
+        if (gz->stream)
+            ret = more(gz);
+        else if ((ret = next(gz)) == 0)
+            break;                      // end of the members
+        if (ret < 0)
+            gz->err = ret;
+    }
+    return got || gz->err == Z_OK ? (ptrdiff_t)got : gz->err;
+}
+
+// See comments in gzpar.h.
+gzpar_t gzpar_open(const char *path, int threads) {
+    gzpar_t gz = malloc(sizeof(struct gzpar_s));
+    if (gz == NULL)
+        return NULL;
+    gz->strm.zalloc = Z_NULL;
+    gz->strm.zfree = Z_NULL;
+    gz->strm.opaque = Z_NULL;
+    gz->strm.avail_in = 0;
+    gz->strm.next_in = Z_NULL;
+    if (inflateInit2(&gz->strm, 31) != Z_OK) {
+        free(gz);
+        return NULL;
+    }
+    struct stat st;
+    gz->fd = open(path, O_RDONLY);
+    if (gz->fd == -1 || fstat(gz->fd, &st)) {
+        if (gz->fd != -1)
+            close(gz->fd);
+        inflateEnd(&gz->strm);
+        free(gz);
+        return NULL;
+    }
+    gz->size = st.st_size;
+    gz->err = Z_OK;
+    gz->jobs = NULL;
+    gz->have = gz->room = 0;
+    gz->base = 0;
+    gz->first = gz->take = 0;
+    gz->scan = 0;
+    gz->quit = 0;
+    gz->expect = 0;
+    gz->own = gz->next = NULL;
+    gz->left = 0;
+    gz->stream = 0;
+    pthread_mutex_init(&gz->lock, NULL);
+    pthread_cond_init(&gz->cond, NULL);
+
+    // Start the workers. If some can't be started, go with what we have.
+    gz->threads = 0;
+    gz->pool = threads > 0 ? malloc(threads * sizeof(pthread_t)) : NULL;
+    if (gz->pool != NULL)
+        while (gz->threads < threads &&
+               pthread_create(gz->pool + gz->threads, NULL, worker, gz) == 0)
+            gz->threads++;
+    return gz;
+}
+
+// See comments in gzpar.h.
+int gzpar_close(gzpar_t gz) {
+    pthread_mutex_lock(&gz->lock);
+    gz->quit = 1;
+    pthread_cond_broadcast(&gz->cond);
+    pthread_mutex_unlock(&gz->lock);
+    while (gz->threads)
+        pthread_join(gz->pool[--gz->threads], NULL);
+    free(gz->pool);
+    for (int i = 0; i < gz->have; i++)
+        free(gz->jobs[i].out);
+    free(gz->jobs);
+    free(gz->own);
+    inflateEnd(&gz->strm);
+    pthread_cond_destroy(&gz->cond);
+    pthread_mutex_destroy(&gz->lock);
+    int ret = close(gz->fd) ? Z_ERRNO : Z_OK;
+    free(gz);
+    return ret;
+}
+
+#ifdef TEST
+
+// Decompress the gzip file named on the command line to stdout, using the
+// number of threads given as an optional second argument (default 4).
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: gzpar file.gz [threads]\n");
+        return 1;
+    }
+    int threads = argc == 3 ? atoi(argv[2]) : 4;
+    gzpar_t gz = gzpar_open(argv[1], threads);
+    if (gz == NULL) {
+        fprintf(stderr, "gzpar: could not open %s\n", argv[1]);
+        return 1;
+    }
+    static unsigned char buf[131072];
+    ptrdiff_t got;
+    while ((got = gzpar_read(gz, buf, sizeof(buf))) > 0)
+        fwrite(buf, 1, got, stdout);
+    gzpar_close(gz);
+    if (got < 0) {
+        fprintf(stderr, "gzpar: %s\n", got == Z_ERRNO ? strerror(errno) :
+                                       zError((int)got));
+        return 1;
+    }
+    return 0;
+}
+
+#endif
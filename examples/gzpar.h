@@ -0,0 +1,30 @@
+/* gzpar.h -- parallel reading of gzip files with multiple members
+ * Copyright (C) 2024 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ * Version 1.0  19 Oct 2026  Mark Adler */
+
+#include <stddef.h>
+
+// Open state for reading a gzip file.
+typedef struct gzpar_s *gzpar_t;
+
+// Open the gzip file at path for reading, decompressing its gzip members on
+// up to threads worker threads. Return NULL if the file could not be opened or
+// if out of memory. Files with many independent members, such as BGZF files,
+// files written by rotating writers, or files made by concatenating gzip
+// files, are decompressed in parallel. A file with a single member is
+// decompressed in the calling thread, as gzread() would.
+gzpar_t gzpar_open(const char *path, int threads);
+
+// Read up to len bytes of decompressed data into buf. Return the number of
+// bytes read, which is less than len only at the end of the data, or a
+// negative zlib error code: Z_ERRNO for a file read error, Z_DATA_ERROR for
+// invalid compressed data or a failed integrity check, Z_BUF_ERROR if the
+// compressed data ended prematurely, or Z_MEM_ERROR if out of memory. As with
+// gzread(), anything after the last member that is not another member is
+// ignored.
+ptrdiff_t gzpar_read(gzpar_t gz, void *buf, size_t len);
+
+// Stop the threads, close the file, and free gz. Return 0, or Z_ERRNO if the
+// close failed.
+int gzpar_close(gzpar_t gz);
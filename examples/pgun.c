@@ -0,0 +1,911 @@
+/* pgun.c -- parallel speculative decompression of gzip streams
+ * Copyright (C) 2024 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ * Version 1.0  19 Oct 2026  Mark Adler */
+
+/* Version History:
+ 1.0  19 Oct 2026  First version
+ */
+
+// Decompress a gzip file using multiple threads, even though the deflate
+// stream has no index and no flush points. The approach is the one used by
+// pugz and rapidgzip. The compressed data is divided into chunks of a fixed
+// size. The first chunk is decoded normally. For each of the other chunks, a
+// worker thread searches forward from the start of the chunk for a bit
+// position that looks like the start of a deflate block, and tries to decode
+// from there. It does not know the 32K of uncompressed data that precedes that
+// point, so it decodes into 16-bit symbols, where a value of 256 + i is a
+// marker that stands for byte i of the unknown window. Matches copy the
+// markers along with the literals. The worker stops at the first block
+// boundary at or after the start of the next chunk.
+//
+// The main thread then stitches the chunks together in order. If the block
+// boundary where the previous chunk ended is exactly where the worker started,
+// then the worker's output is correct, since decoding from a true block
+// boundary is deterministic. The window is now known, so the markers are
+// replaced with the bytes they stand for, and the result is written out. If
+// the worker guessed wrong, gave up, or found no block start (it does not look
+// for fixed blocks, which are too easily mistaken), then the main thread
+// decodes from where the previous chunk ended one block at a time with the
+// known window, until it gets to where the worker started or passes into the
+// next chunk. The speculative work is only an accelerator -- the output is
+// always that of a sequential decode, and the CRC-32 and length in the gzip
+// trailer are checked as usual. At worst, for example when every block in the
+// file is fixed, or the data is so compressible that a worker exceeds its
+// output limit, pgun degrades to a single-threaded decode.
+//
+// The chunks cover the whole file, and the same workers serve all of the
+// members of a multiple-member gzip file. A worker stops at the end of a
+// member, and the main thread decodes the rest of that chunk, so a file of
+// many small members is decoded mostly by the main thread, at about the speed
+// of a sequential decode.
+//
+// This is an example, so the entire compressed input is read into memory, and
+// the deflate decoder is a simple one in the style of puff.c with a lookup
+// table for short codes. Compile with -lpthread -lz.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "zlib.h"
+
+#define WINSIZE 32768U      // deflate window size
+#define MAXBITS 15          // maximum bits in a code
+#define MAXLCODES 286       // maximum number of literal/length codes
+#define MAXDCODES 30        // maximum number of distance codes
+#define MAXCODES (MAXLCODES + MAXDCODES)
+#define FIXLCODES 288       // number of fixed literal/length codes
+#define FAST 10             // bits in the lookup table for short codes
+#define CHUNK 1048576       // default compressed chunk size
+#define GROW 32             // maximum expansion of a chunk by a worker
+
+// Decoder errors. Any of these from a speculative decode just means that the
+// guess was wrong.
+#define EOVER -1            // ran out of input
+#define EBLOCK -2           // invalid block type or stored block length
+#define ECODE -3            // invalid code lengths or symbol
+#define EDIST -4            // distance too far back
+#define EMEM -5             // out of memory, or worker output limit exceeded
+
+// Input bits from the compressed data in memory. The position in bits of the
+// next bit to be read is next * 8 - have.
+typedef struct {
+    const unsigned char *buf;   // compressed data
+    size_t len;                 // length of compressed data
+    size_t next;                // next byte to load into hold
+    uint64_t hold;              // bit accumulator
+    unsigned have;              // number of bits in hold
+    int over;                   // true if tried to read past the end
+} bits_t;
+
+// Set up s to read from bit position pos in buf[0..len-1].
+static void bits_at(bits_t *s, const unsigned char *buf, size_t len,
+                    size_t pos) {
+    s->buf = buf;
+    s->len = len;
+    s->next = pos >> 3;
+    s->hold = 0;
+    s->have = 0;
+    s->over = 0;
+    if (pos & 7) {
+        s->hold = s->next < len ? buf[s->next] >> (pos & 7) : 0;
+        s->over = s->next >= len;
+        s->next++;
+        s->have = 8 - (pos & 7);
+    }
+}
+
+// Return the bit position of the next bit to be read from s.
+static inline size_t bits_pos(bits_t *s) {
+    return (s->next << 3) - s->have;
+}
+
+// Fill s->hold with at least 57 bits. Past the end of the input, zeros are
+// loaded and s->over is set.
+static inline void refill(bits_t *s) {
+    while (s->have <= 56) {
+        if (s->next < s->len)
+            s->hold |= (uint64_t)s->buf[s->next] << s->have;
+        else
+            s->over = 1;
+        s->next++;
+        s->have += 8;
+    }
+}
+
+// Return need bits from s, need <= 16.
+static inline unsigned bits(bits_t *s, unsigned need) {
+    if (s->have < need)
+        refill(s);
+    unsigned val = (unsigned)s->hold & ((1U << need) - 1);
+    s->hold >>= need;
+    s->have -= need;
+    return val;
+}
+
+// Huffman code decoding tables, as in puff.c, plus a lookup table indexed by
+// the next FAST bits of input. An entry in fast is the code length times 512
+// plus the symbol, or zero if the code is longer than FAST bits or invalid.
+typedef struct {
+    short count[MAXBITS + 1];   // number of symbols of each length
+    short symbol[FIXLCODES];    // canonically ordered symbols
+    unsigned short fast[1U << FAST];    // lookup table for short codes
+} huff_t;
+
+// Count the code lengths length[0..n-1] into h->count. Return zero for a
+// complete code, positive for an incomplete code, or negative for an
+// over-subscribed code.
+static int huff_count(huff_t *h, const short *length, int n) {
+    memset(h->count, 0, sizeof(h->count));
+    for (int sym = 0; sym < n; sym++)
+        h->count[length[sym]]++;
+    if (h->count[0] == n)
+        return 0;                   // complete, but decode() will fail
+    int left = 1;
+    for (int len = 1; len <= MAXBITS; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0)
+            return left;
+    }
+    return left;
+}
+
+// Fill in h->symbol, and h->fast if fast is true, from the code lengths after
+// huff_count() has been applied and has not returned negative.
+static void huff_fill(huff_t *h, const short *length, int n, int fast) {
+    short offs[MAXBITS + 1];
+    offs[1] = 0;
+    for (int len = 1; len < MAXBITS; len++)
+        offs[len + 1] = offs[len] + h->count[len];
+    for (int sym = 0; sym < n; sym++)
+        if (length[sym] != 0)
+            h->symbol[offs[length[sym]]++] = sym;
+    if (!fast)
+        return;
+
+    // Put the codes of FAST bits or less in the lookup table. Deflate codes
+    // are sent starting with the most significant bit, so the table is indexed
+    // by the bit-reversed code.
+    memset(h->fast, 0, sizeof(h->fast));
+    unsigned code = 0;
+    int index = 0;
+    for (unsigned len = 1; len <= FAST; len++) {
+        for (int k = 0; k < h->count[len]; k++, index++, code++) {
+            unsigned rev = 0;
+            for (unsigned b = 0; b < len; b++)
+                rev |= ((code >> b) & 1) << (len - 1 - b);
+            for (; rev < (1U << FAST); rev += 1U << len)
+                h->fast[rev] = (len << 9) | h->symbol[index];
+        }
+        code <<= 1;
+    }
+}
+
+// Decode a symbol from s using h a bit at a time, as in puff.c, without using
+// the lookup table. Return the symbol, or ECODE if the code is invalid.
+static int decode_slow(bits_t *s, const huff_t *h) {
+    refill(s);
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len <= MAXBITS; len++) {
+        code |= (int)(s->hold >> (len - 1)) & 1;
+        int count = h->count[len];
+        if (code - count < first) {
+            s->hold >>= len;
+            s->have -= len;
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return ECODE;
+}
+
+// Decode a symbol from s using h, which must have a lookup table. Return the
+// symbol, or ECODE if the code is invalid.
+static inline int decode(bits_t *s, const huff_t *h) {
+    refill(s);
+    unsigned entry = h->fast[s->hold & ((1U << FAST) - 1)];
+    if (entry) {
+        s->hold >>= entry >> 9;
+        s->have -= entry >> 9;
+        return entry & 511;
+    }
+    return decode_slow(s, h);
+}
+
+// Decoded output as 16-bit values: 0..255 for known bytes, or 256 + i for
+// byte i of an unknown window.
+typedef struct {
+    uint16_t *data;     // decoded values
+    size_t have;        // number of values in data
+    size_t size;        // allocated size of data
+    size_t max;         // maximum size of data, or 0 for no limit
+} out_t;
+
+// Make room for at least room more values in o. Return 0 on success or EMEM.
+static int room(out_t *o, size_t room) {
+    if (o->size - o->have >= room)
+        return 0;
+    size_t size = o->size ? o->size : WINSIZE << 1;
+    while (size - o->have < room)
+        size <<= 1;
+    if (o->max && size > o->max) {
+        size = o->max;
+        if (size - o->have < room)
+            return EMEM;
+    }
+    uint16_t *data = realloc(o->data, size * sizeof(uint16_t));
+    if (data == NULL)
+        return EMEM;
+    o->data = data;
+    o->size = size;
+    return 0;
+}
+
+// Fixed literal/length and distance codes, built once by main().
+static huff_t fixlen, fixdist;
+
+// Decode the literals and matches of a block from s into o, using the codes
+// lencode and distcode.
+static int codes(bits_t *s, out_t *o, const huff_t *lencode,
+                 const huff_t *distcode) {
+    static const short lbase[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const short lext[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const short dbase[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+        8193, 12289, 16385, 24577};
+    static const short dext[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+        12, 12, 13, 13};
+
+    for (;;) {
+        if (o->size - o->have < 258 && room(o, 258))
+            return EMEM;
+        int sym = decode(s, lencode);
+        if (sym < 256) {
+            if (sym < 0)
+                return sym;
+            o->data[o->have++] = sym;
+        }
+        else if (sym == 256)
+            break;
+        else {
+            sym -= 257;
+            if (sym >= 29)
+                return ECODE;
+            unsigned len = lbase[sym] + bits(s, lext[sym]);
+            sym = decode(s, distcode);
+            if (sym < 0)
+                return sym;
+            size_t dist = dbase[sym] + bits(s, dext[sym]);
+            if (dist > o->have)
+                return EDIST;
+            uint16_t *to = o->data + o->have;
+            const uint16_t *from = to - dist;
+            o->have += len;
+            do {
+                *to++ = *from++;
+            } while (--len);
+        }
+        if (s->over)
+            return EOVER;
+    }
+    return s->over ? EOVER : 0;
+}
+
+// Decode a stored block from s into o. The block type bits have been read.
+static int stored(bits_t *s, out_t *o) {
+    bits(s, s->have & 7);           // go to a byte boundary
+    unsigned len = bits(s, 16);
+    if (len != (~bits(s, 16) & 0xffff))
+        return EBLOCK;
+    if (room(o, len))
+        return EMEM;
+    while (len--)
+        o->data[o->have++] = bits(s, 8);
+    return s->over ? EOVER : 0;
+}
+
+// Read the code lengths of a dynamic block from s and build lencode and
+// distcode. The block type bits have been read. If fast is false, check the
+// header without building the decoding tables.
+static int dynamic(bits_t *s, huff_t *lencode, huff_t *distcode, int fast) {
+    static const short order[19] = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    short lengths[MAXCODES];
+
+    // Get the numbers of lengths in each table, and check them.
+    int nlen = bits(s, 5) + 257;
+    int ndist = bits(s, 5) + 1;
+    int ncode = bits(s, 4) + 4;
+    if (nlen > MAXLCODES || ndist > MAXDCODES)
+        return ECODE;
+
+    // Read and build the code length code, which must be complete.
+    int index;
+    for (index = 0; index < ncode; index++)
+        lengths[order[index]] = bits(s, 3);
+    for (; index < 19; index++)
+        lengths[order[index]] = 0;
+    if (huff_count(lencode, lengths, 19) != 0)
+        return ECODE;
+    huff_fill(lencode, lengths, 19, 0);
+
+    // Read the literal/length and distance code lengths.
+    index = 0;
+    while (index < nlen + ndist) {
+        int symbol = decode_slow(s, lencode);
+        if (symbol < 0)
+            return symbol;
+        if (symbol < 16)
+            lengths[index++] = symbol;
+        else {
+            int len = 0, rep;
+            if (symbol == 16) {
+                if (index == 0)
+                    return ECODE;
+                len = lengths[index - 1];
+                rep = 3 + bits(s, 2);
+            }
+            else if (symbol == 17)
+                rep = 3 + bits(s, 3);
+            else
+                rep = 11 + bits(s, 7);
+            if (index + rep > nlen + ndist)
+                return ECODE;
+            while (rep--)
+                lengths[index++] = len;
+        }
+    }
+    if (s->over)
+        return EOVER;
+
+    // The end-of-block code must be present, and the codes must be complete,
+    // except that a code may be a single code of length one, as for inflate.
+    if (lengths[256] == 0)
+        return ECODE;
+    int err = huff_count(lencode, lengths, nlen);
+    if (err < 0 || (err > 0 && (nlen - lencode->count[0] != 1 ||
+                                lencode->count[1] != 1)))
+        return ECODE;
+    err = huff_count(distcode, lengths + nlen, ndist);
+    if (err < 0 || (err > 0 && (ndist - distcode->count[0] != 1 ||
+                                distcode->count[1] != 1)))
+        return ECODE;
+    if (fast) {
+        huff_fill(lencode, lengths, nlen, 1);
+        huff_fill(distcode, lengths + nlen, ndist, 1);
+    }
+    return 0;
+}
+
+// Decode deflate blocks from s into o, until the end of the last block, or
+// until at a block boundary at or after the bit position stop. Set *last to
+// true if the last block was decoded. Stop early if *quit becomes true.
+static int blocks(bits_t *s, out_t *o, size_t stop, int *last,
+                  volatile int *quit) {
+    huff_t lencode, distcode;
+    *last = 0;
+    do {
+        int fin = bits(s, 1);
+        int type = bits(s, 2);
+        int err = type == 0 ? stored(s, o) :
+                  type == 1 ? codes(s, o, &fixlen, &fixdist) :
+                  type == 2 ? dynamic(s, &lencode, &distcode, 1) : EBLOCK;
+        if (type == 2 && err == 0)
+            err = codes(s, o, &lencode, &distcode);
+        if (err)
+            return err;
+        if (fin) {
+            *last = 1;
+            break;
+        }
+    } while (bits_pos(s) < stop && !*quit);
+    return 0;
+}
+
+// Return true if a dynamic or stored block header can be decoded at bit
+// position pos in buf[0..len-1]. The padding before the length of a stored
+// block must be zeros, as written by deflate. A random stored header turns up
+// about once every 32K bytes, so unless it is the last block, a stored block
+// must also be followed by another candidate if more is true.
+static int candidate(const unsigned char *buf, size_t len, size_t pos,
+                     int more) {
+    bits_t s;
+    bits_at(&s, buf, len, pos);
+    int fin = bits(&s, 1);
+    int type = bits(&s, 2);
+    if (type == 2) {
+        huff_t lencode, distcode;
+        return dynamic(&s, &lencode, &distcode, 0) == 0;
+    }
+    if (type == 0) {
+        if (bits(&s, s.have & 7) != 0)
+            return 0;
+        unsigned n = bits(&s, 16);
+        if (n != (~bits(&s, 16) & 0xffff) || s.over)
+            return 0;
+        pos = bits_pos(&s) + ((size_t)n << 3);
+        return fin || !more || (pos < len << 3 &&
+                                candidate(buf, len, pos, 0));
+    }
+    return 0;
+}
+
+// A chunk of compressed data, and what a worker found there.
+typedef struct {
+    int done;           // true when the worker is done with this chunk
+    int found;          // true if the worker decoded from start to end
+    size_t start;       // bit position where decoding started
+    size_t end;         // bit position where decoding ended
+    int last;           // true if decoding ended at the end of the member
+    out_t out;          // WINSIZE markers, followed by the decoded data
+} chunk_t;
+
+// Work shared between the main thread and the workers. The chunks cover the
+// whole input, from the start of the first member's deflate data.
+typedef struct {
+    const unsigned char *buf;   // compressed data
+    size_t len;                 // length of compressed data
+    size_t first;               // bit position of the first deflate block
+    size_t size;                // chunk size in bytes
+    int chunks;                 // number of chunks
+    chunk_t *chunk;             // the chunks
+    int next;                   // next chunk for a worker to take
+    int stitched;               // number of chunks used by the main thread
+    int ahead;                  // how far past stitched workers can go
+    volatile int quit;          // true to tell the workers to stop
+    pthread_mutex_t lock;       // protects next, stitched, and done
+    pthread_cond_t cond;        // signals changes in stitched and done
+} job_t;
+
+// Return the bit position of the start of chunk k. The last chunk ends at
+// the end of the input.
+static size_t chunk_pos(job_t *job, int k) {
+    return k >= job->chunks ? job->len << 3 :
+                              job->first + ((size_t)k * job->size << 3);
+}
+
+// Return true if the end of a member at bit position pos is plausible, which
+// is if there is room for a trailer, followed by the end of the input or the
+// start of another gzip member.
+static int trailer(job_t *job, size_t pos) {
+    size_t at = ((pos + 7) >> 3) + 8;
+    return at <= job->len && (at == job->len ||
+                              (job->len - at >= 2 && job->buf[at] == 0x1f &&
+                               job->buf[at + 1] == 0x8b));
+}
+
+// Return true if decoding from bit position pos, which is known to be the
+// start of a block, is the same as decoding from bit position start. That is
+// the case if they are the same, or if both are the starts of a stored block
+// with the same last-block bit, and the same byte boundary after the header.
+// Then the worker may have started a few bits early, in the padding or data
+// preceding the stored block.
+static int same(job_t *job, size_t pos, size_t start) {
+    if (pos == start)
+        return 1;
+    if ((pos + 10) >> 3 != (start + 10) >> 3)
+        return 0;
+    bits_t s;
+    bits_at(&s, job->buf, job->len, pos);
+    unsigned a = bits(&s, 3);
+    bits_at(&s, job->buf, job->len, start);
+    return (a & 6) == 0 && a == bits(&s, 3);
+}
+
+// Speculatively decode chunk k. Chunk 0 starts at the start of the first
+// deflate stream with an empty window. The others start at the first bit
+// position in the chunk where decoding succeeds with an unknown window. The
+// decoding stops at the end of a member.
+static void speculate(job_t *job, int k) {
+    chunk_t *c = job->chunk + k;
+    c->out.max = WINSIZE + (size_t)GROW * job->size;
+    if (room(&c->out, WINSIZE))
+        return;
+    for (unsigned i = 0; i < WINSIZE; i++)
+        c->out.data[i] = 256 + i;
+    size_t pos = chunk_pos(job, k), stop = chunk_pos(job, k + 1);
+    size_t end = k ? stop : pos + 1;
+    for (; pos < end && !job->quit; pos++) {
+        if (k && !candidate(job->buf, job->len, pos, 1))
+            continue;
+        bits_t s;
+        bits_at(&s, job->buf, job->len, pos);
+        c->out.have = k ? WINSIZE : 0;
+        if (blocks(&s, &c->out, stop, &c->last, &job->quit) == 0 &&
+            !job->quit && (!c->last || trailer(job, bits_pos(&s)))) {
+            c->found = 1;
+            c->start = pos;
+            c->end = bits_pos(&s);
+            return;
+        }
+    }
+}
+
+// Worker thread: speculatively decode chunks in order until there are no
+// more, or until told to quit.
+static void *worker(void *arg) {
+    job_t *job = arg;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        while (!job->quit && job->next < job->chunks &&
+               job->next >= job->stitched + job->ahead)
+            pthread_cond_wait(&job->cond, &job->lock);
+        if (job->next < job->stitched)
+            job->next = job->stitched;      // skip chunks already passed
+        int k = job->quit || job->next == job->chunks ? -1 : job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (k == -1)
+            break;
+        speculate(job, k);
+        pthread_mutex_lock(&job->lock);
+        job->chunk[k].done = 1;
+        pthread_cond_broadcast(&job->cond);
+        pthread_mutex_unlock(&job->lock);
+    }
+    return NULL;
+}
+
+// Uncompressed data written so far for the current member, with the most
+// recent WINSIZE bytes of it in win[WINSIZE - wlen..WINSIZE-1].
+typedef struct {
+    FILE *out;                  // where to write the uncompressed data
+    unsigned long crc;          // CRC-32 of the member data
+    unsigned long total;        // length of the member data modulo 2^32
+    unsigned wlen;              // number of bytes in window
+    unsigned char win[WINSIZE]; // the last wlen bytes written
+} sink_t;
+
+// Resolve data[0..len-1] to bytes using the window in z, which is the window
+// that preceded the decoding of data. Write the bytes and update z. Return 0
+// on success, -1 on a write error, or 1 if data refers to bytes before the
+// start of the member.
+static int emit(sink_t *z, const uint16_t *data, size_t len) {
+    if (len == 0)
+        return 0;
+    unsigned char *bytes = malloc(len);
+    if (bytes == NULL)
+        return -1;
+    size_t i = 0;
+    do {
+        if (data[i] < 256)
+            bytes[i] = data[i];
+        else if (data[i] - 256U >= WINSIZE - z->wlen)
+            bytes[i] = z->win[data[i] - 256];
+        else {
+            free(bytes);
+            return 1;
+        }
+    } while (++i < len);
+    z->crc = crc32_z(z->crc, bytes, len);
+    int ret = fwrite(bytes, 1, len, z->out) == len ? 0 : -1;
+    z->total += len;
+    if (len >= WINSIZE)
+        memcpy(z->win, bytes + len - WINSIZE, WINSIZE);
+    else {
+        memmove(z->win, z->win + len, WINSIZE - len);
+        memcpy(z->win + WINSIZE - len, bytes, len);
+    }
+    z->wlen = len >= WINSIZE - z->wlen ? WINSIZE : z->wlen + (unsigned)len;
+    free(bytes);
+    return ret;
+}
+
+// Mark chunk k as used by the main thread, which releases a worker to work
+// on a later chunk, and free its output if the worker is done with it.
+// Otherwise the output is freed after the workers are stopped.
+static void release(job_t *job, int k) {
+    pthread_mutex_lock(&job->lock);
+    job->stitched = k + 1;
+    pthread_cond_broadcast(&job->cond);
+    int done = job->chunk[k].done;
+    pthread_mutex_unlock(&job->lock);
+    if (done) {
+        free(job->chunk[k].out.data);
+        job->chunk[k].out.data = NULL;
+    }
+}
+
+// Decode the deflate stream that starts at bit position pos in job->buf, and
+// write the result to z->out. started is the number of worker threads, and *k
+// is the chunk that pos is in, which is updated. Return the bit position after
+// the end of the stream, or 0 on error with *err set to an error message.
+static size_t member(job_t *job, size_t pos, sink_t *z, int started, int *k,
+                     const char **err) {
+    // Stitch together the chunks in order, decoding between them as needed.
+    out_t seq = {NULL, 0, 0, 0};
+    int last = 0, ret;
+    *err = NULL;
+    while (!last) {
+        // Move on to the chunk that pos is in. The rest of a chunk after the
+        // end of a member is decoded here, since the worker stopped there.
+        while (*k < job->chunks && pos >= chunk_pos(job, *k + 1))
+            release(job, (*k)++);
+
+        chunk_t *c = NULL;
+        if (*k < job->chunks) {
+            c = job->chunk + *k;
+            if (started == 0) {
+                if (job->next <= *k) {
+                    job->next = *k + 1;
+                    speculate(job, *k);
+                    c->done = 1;
+                }
+            }
+            else {
+                pthread_mutex_lock(&job->lock);
+                while (!c->done)
+                    pthread_cond_wait(&job->cond, &job->lock);
+                pthread_mutex_unlock(&job->lock);
+            }
+        }
+
+        if (c != NULL && c->found && same(job, pos, c->start)) {
+            // The worker started where the previous chunk ended. Use it.
+            ret = emit(z, c->out.data + (*k ? WINSIZE : 0),
+                       c->out.have - (*k ? WINSIZE : 0));
+            if (ret) {
+                *err = ret < 0 ? "write error" : "invalid deflate data";
+                break;
+            }
+            pos = c->end;
+            last = c->last;
+        }
+        else {
+            // Decode one block with the known window.
+            if (seq.size == 0 && room(&seq, WINSIZE)) {
+                *err = "out of memory";
+                break;
+            }
+            for (unsigned i = 0; i < z->wlen; i++)
+                seq.data[i] = z->win[WINSIZE - z->wlen + i];
+            seq.have = z->wlen;
+            bits_t s;
+            bits_at(&s, job->buf, job->len, pos);
+            int quit = 0;
+            ret = blocks(&s, &seq, pos + 1, &last, &quit);
+            if (ret) {
+                *err = ret == EMEM ? "out of memory" :
+                       ret == EOVER ? "unexpected end of input" :
+                                      "invalid deflate data";
+                break;
+            }
+            if (emit(z, seq.data + z->wlen, seq.have - z->wlen)) {
+                *err = "write error";
+                break;
+            }
+            pos = bits_pos(&s);
+        }
+    }
+    free(seq.data);
+    return *err == NULL ? pos : 0;
+}
+
+// Return the offset after the gzip header at buf[at], or 0 if there isn't a
+// valid gzip header there.
+static size_t header(const unsigned char *buf, size_t len, size_t at) {
+    if (len - at < 10 || buf[at] != 0x1f || buf[at + 1] != 0x8b ||
+        buf[at + 2] != 8 || (buf[at + 3] & 0xe0))
+        return 0;
+    int flags = buf[at + 3];
+    size_t pos = at + 10;
+    if (flags & 4) {
+        if (len - pos < 2)
+            return 0;
+        pos += 2 + (buf[pos] | ((size_t)buf[pos + 1] << 8));
+    }
+    if (flags & 8) {
+        while (pos < len && buf[pos])
+            pos++;
+        pos++;
+    }
+    if (flags & 16) {
+        while (pos < len && buf[pos])
+            pos++;
+        pos++;
+    }
+    if (flags & 2)
+        pos += 2;
+    return pos < len ? pos : 0;
+}
+
+// Return the four-byte little-endian integer at p.
+static unsigned long get4(const unsigned char *p) {
+    return p[0] | ((unsigned long)p[1] << 8) | ((unsigned long)p[2] << 16) |
+           ((unsigned long)p[3] << 24);
+}
+
+// Decompress the gzip data in buf[0..len-1] to out using threads threads and
+// chunks of size bytes. Return NULL on success, or an error message.
+static const char *pgun(const unsigned char *buf, size_t len, FILE *out,
+                        int threads, size_t size) {
+    size_t pos = header(buf, len, 0);
+    if (pos == 0)
+        return "not a gzip file";
+    sink_t *z = malloc(sizeof(sink_t));
+    if (z == NULL)
+        return "out of memory";
+    z->out = out;
+
+    // Divide the input into chunks, and start the workers. The same chunks
+    // and workers are used for all of the members.
+    job_t job;
+    job.buf = buf;
+    job.len = len;
+    job.first = pos << 3;
+    size_t n = ((len << 3) - job.first + (size << 3) - 1) / (size << 3);
+    job.chunks = n > INT_MAX ? INT_MAX : (int)n;
+    if (job.chunks < 1)
+        job.chunks = 1;
+    job.size = ((len << 3) - job.first + ((size_t)job.chunks << 3) - 1) /
+               ((size_t)job.chunks << 3);
+    job.chunk = calloc(job.chunks, sizeof(chunk_t));
+    if (job.chunk == NULL) {
+        free(z);
+        return "out of memory";
+    }
+    job.next = 0;
+    job.stitched = 0;
+    job.ahead = threads << 1;
+    job.quit = 0;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.cond, NULL);
+    pthread_t *pool = malloc(threads * sizeof(pthread_t));
+    int started = 0;
+    if (pool != NULL)
+        while (started < threads &&
+               pthread_create(pool + started, NULL, worker, &job) == 0)
+            started++;
+    if (started == 0) {
+        // No threads -- do the speculation here, one chunk at a time.
+        job.ahead = 1;
+    }
+
+    const char *err = NULL;
+    size_t at = 0;
+    int k = 0;
+    do {
+        // Process one gzip member.
+        if (at) {
+            pos = header(buf, len, at);
+            if (pos == 0) {
+                err = "invalid gzip header after first member";
+                break;
+            }
+        }
+        z->crc = crc32(0, Z_NULL, 0);
+        z->total = 0;
+        z->wlen = 0;
+        pos = member(&job, pos << 3, z, started, &k, &err);
+        if (pos == 0)
+            break;
+        at = (pos + 7) >> 3;
+        if (len - at < 8) {
+            err = "unexpected end of input";
+            break;
+        }
+        if (get4(buf + at) != z->crc || get4(buf + at + 4) != z->total) {
+            err = "gzip trailer check failed";
+            break;
+        }
+        at += 8;
+
+        // Continue with the next member, if any.
+    } while (len - at >= 2 && buf[at] == 0x1f && buf[at + 1] == 0x8b);
+
+    // Stop the workers and clean up.
+    pthread_mutex_lock(&job.lock);
+    job.quit = 1;
+    pthread_cond_broadcast(&job.cond);
+    pthread_mutex_unlock(&job.lock);
+    while (started)
+        pthread_join(pool[--started], NULL);
+    free(pool);
+    for (int i = 0; i < job.chunks; i++)
+        free(job.chunk[i].out.data);
+    free(job.chunk);
+    pthread_cond_destroy(&job.cond);
+    pthread_mutex_destroy(&job.lock);
+    free(z);
+    return err;
+}
+
+// Build a decoding table for the fixed codes.
+static void fixed(void) {
+    short lengths[FIXLCODES];
+    int sym;
+    for (sym = 0; sym < 144; sym++)
+        lengths[sym] = 8;
+    for (; sym < 256; sym++)
+        lengths[sym] = 9;
+    for (; sym < 280; sym++)
+        lengths[sym] = 7;
+    for (; sym < FIXLCODES; sym++)
+        lengths[sym] = 8;
+    huff_count(&fixlen, lengths, FIXLCODES);
+    huff_fill(&fixlen, lengths, FIXLCODES, 1);
+    for (sym = 0; sym < MAXDCODES; sym++)
+        lengths[sym] = 5;
+    huff_count(&fixdist, lengths, MAXDCODES);
+    huff_fill(&fixdist, lengths, MAXDCODES, 1);
+}
+
+// Decompress a gzip file named on the command line, or stdin if none, to
+// stdout. Options: -t n to use n worker threads (default is the number of
+// processors), -c n for a chunk size of n KiB (default 1024).
+int main(int argc, char **argv) {
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t size = CHUNK;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-' && argv[arg][1]; arg++) {
+        char *end;
+        long val = arg + 1 < argc ? strtol(argv[arg + 1], &end, 10) : 0;
+        if (val < 1 || *end || (strcmp(argv[arg], "-t") &&
+                                strcmp(argv[arg], "-c"))) {
+            fprintf(stderr, "usage: pgun [-t threads] [-c kib] [file.gz]\n");
+            return 1;
+        }
+        if (argv[arg][1] == 't')
+            threads = val;
+        else
+            size = (size_t)val << 10;
+        arg++;
+    }
+    if (threads < 1)
+        threads = 1;
+    if (arg + 1 < argc) {
+        fprintf(stderr, "usage: pgun [-t threads] [-c kib] [file.gz]\n");
+        return 1;
+    }
+
+    // Read all of the input into memory.
+    FILE *in = arg < argc ? fopen(argv[arg], "rb") : stdin;
+    if (in == NULL) {
+        fprintf(stderr, "pgun: could not open %s\n", argv[arg]);
+        return 1;
+    }
+    size_t len = 0, max = 1048576;
+    unsigned char *buf = malloc(max);
+    while (buf != NULL) {
+        len += fread(buf + len, 1, max - len, in);
+        if (len < max)
+            break;
+        unsigned char *more = realloc(buf, max <<= 1);
+        if (more == NULL)
+            free(buf);
+        buf = more;
+    }
+    if (buf == NULL || ferror(in)) {
+        fprintf(stderr, "pgun: %s\n", buf == NULL ? "out of memory" :
+                                                    "read error");
+        return 1;
+    }
+    if (in != stdin)
+        fclose(in);
+
+    // Decompress.
+    fixed();
+    const char *err = pgun(buf, len, stdout, (int)threads, size);
+    free(buf);
+    if (err == NULL && fflush(stdout))
+        err = "write error";
+    if (err != NULL) {
+        fprintf(stderr, "pgun: %s\n", err);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,353 @@
+/* zdict.c -- train a preset dictionary for deflate from sample messages
+ * Copyright (C) 2024 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ * Version 1.0  19 Oct 2026  Mark Adler */
+
+/* Version History:
+ 1.0  19 Oct 2026  First version
+ */
+
+// A preset dictionary lets deflate find matches in the very first bytes of a
+// message, which for short messages is the difference between compressing
+// well and hardly compressing at all. Any data can be used as a dictionary,
+// but the best dictionary for a set of messages contains the strings that
+// recur across those messages, with the most common strings at the end, where
+// they are closest to the message and so have the shortest distance codes.
+//
+// zdict_train() builds such a dictionary from sample messages using a
+// segment selection method. Each string of DMER bytes in the samples is
+// counted by the number of samples it appears in. The samples are divided into
+// as many epochs as there are segments of SEG bytes in the dictionary. From
+// each epoch, the segment with the highest total count of its distinct strings
+// is chosen, and the counts of those strings are then set to zero, so that
+// later segments add different content. The first segments chosen are the most
+// valuable, and are placed at the end of the dictionary. Strings are counted
+// by a hash of their contents, so an occasional collision can credit a string
+// with another string's count, which is of little consequence here.
+//
+// Compiled with -DTEST, this provides a command-line tool to make a dictionary
+// from sample files, and to show how well the samples compress with it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "zdict.h"
+
+#define DMER 6          // length of the strings counted
+#define SEG 256         // length of a dictionary segment, plus DMER - 1
+#define BITS 20         // number of bits in the string hash
+
+// Return a hash of the DMER bytes at p.
+static inline uint32_t hash(const unsigned char *p) {
+    uint64_t val = 0;
+    for (int i = 0; i < DMER; i++)
+        val = (val << 8) | p[i];
+    return (uint32_t)((val * 0x9e3779b97f4a7c15) >> (64 - BITS));
+}
+
+// Training state.
+typedef struct {
+    size_t len;             // total length of the samples
+    unsigned char *all;     // the samples, concatenated
+    uint32_t *at;           // hash of the string at each position, or NONE
+    uint32_t *freq;         // number of samples containing each string
+    uint16_t *win;          // number of times each string is in the window
+} train_t;
+
+#define NONE UINT32_MAX     // no string at this position
+
+// Find the segment in the positions first..last-1 of t->all with the highest
+// score, the sum of the counts of the distinct strings that start in it.
+// Return the score, with the start of the segment in *best.
+static uint64_t segment(train_t *t, size_t first, size_t last, size_t *best) {
+    uint64_t score = 0, top = 0;
+    *best = first;
+    for (size_t i = first; i < last; i++) {
+        // add the string at i to the window
+        uint32_t h = t->at[i];
+        if (h != NONE && t->win[h]++ == 0)
+            score += t->freq[h];
+
+        // remove the string that dropped out of the window
+        if (i - first >= SEG) {
+            h = t->at[i - SEG];
+            if (h != NONE && --t->win[h] == 0)
+                score -= t->freq[h];
+        }
+
+        // note the best window so far
+        if (score > top) {
+            top = score;
+            *best = i + 1 > SEG ? i + 1 - SEG : 0;
+            if (*best < first)
+                *best = first;
+        }
+    }
+
+    // empty the window
+    for (size_t i = last > first + SEG ? last - SEG : first; i < last; i++)
+        if (t->at[i] != NONE)
+            t->win[t->at[i]]--;
+    return top;
+}
+
+// See comments in zdict.h.
+long zdict_train(unsigned char *dict, size_t size,
+                 const unsigned char *const *samples, const size_t *lens,
+                 size_t count) {
+    // gather the samples
+    train_t t;
+    t.len = 0;
+    for (size_t n = 0; n < count; n++)
+        t.len += lens[n];
+    if (size == 0 || t.len < DMER)
+        return 0;
+    t.all = malloc(t.len);
+    t.at = malloc(t.len * sizeof(uint32_t));
+    t.freq = calloc((size_t)1 << BITS, sizeof(uint32_t));
+    t.win = calloc((size_t)1 << BITS, sizeof(uint16_t));
+    uint32_t *seen = calloc((size_t)1 << BITS, sizeof(uint32_t));
+    if (t.all == NULL || t.at == NULL || t.freq == NULL || t.win == NULL ||
+        seen == NULL) {
+        free(seen);
+        free(t.win);
+        free(t.freq);
+        free(t.at);
+        free(t.all);
+        return -1;
+    }
+
+    // hash the strings in each sample, and count the samples they are in
+    size_t pos = 0;
+    for (size_t n = 0; n < count; n++) {
+        memcpy(t.all + pos, samples[n], lens[n]);
+        for (size_t i = 0; i < lens[n]; i++, pos++) {
+            if (i + DMER > lens[n]) {
+                t.at[pos] = NONE;
+                continue;
+            }
+            uint32_t h = hash(t.all + pos);
+            t.at[pos] = h;
+            if (seen[h] != n + 1) {
+                seen[h] = (uint32_t)n + 1;
+                t.freq[h]++;
+            }
+        }
+    }
+    free(seen);
+
+    // a string in only one sample is of no use to the other messages
+    for (size_t h = 0; h < ((size_t)1 << BITS); h++)
+        if (t.freq[h] < 2)
+            t.freq[h] = 0;
+
+    // choose segments from successive epochs, filling the dictionary from
+    // the end, until it is full or there is nothing left worth adding
+    size_t segs = (size + SEG - 1) / SEG;
+    size_t epoch = t.len / segs;
+    if (epoch < 2 * SEG)
+        epoch = 2 * SEG;
+    size_t epochs = (t.len + epoch - 1) / epoch;
+    size_t fill = 0, e = 0, idle = 0;
+    while (fill < size && idle < epochs) {
+        size_t first = e * epoch;
+        size_t last = first + epoch < t.len ? first + epoch : t.len;
+        e = e + 1 < epochs ? e + 1 : 0;
+        size_t beg;
+        if (segment(&t, first, last, &beg) == 0) {
+            idle++;
+            continue;
+        }
+        idle = 0;
+
+        // trim strings of no value from the ends of the segment
+        size_t end = beg + SEG < last ? beg + SEG : last;
+        while (beg < end && (t.at[beg] == NONE || t.freq[t.at[beg]] == 0))
+            beg++;
+        while (end > beg &&
+               (t.at[end - 1] == NONE || t.freq[t.at[end - 1]] == 0))
+            end--;
+
+        // use those strings up, and add the segment's bytes, including the
+        // rest of the last string, in front of what's in the dictionary
+        for (size_t i = beg; i < end; i++)
+            if (t.at[i] != NONE)
+                t.freq[t.at[i]] = 0;
+        end += DMER - 1;
+        size_t n = end - beg;
+        if (n > size - fill) {
+            beg += n - (size - fill);
+            n = size - fill;
+        }
+        fill += n;
+        memcpy(dict + size - fill, t.all + beg, n);
+    }
+
+    // move the dictionary to the start of dict
+    if (fill < size)
+        memmove(dict, dict + size - fill, fill);
+    free(t.win);
+    free(t.freq);
+    free(t.at);
+    free(t.all);
+    return (long)fill;
+}
+
+#ifdef TEST
+
+#include "zlib.h"
+
+// Read the file at path into allocated memory. Return NULL on failure.
+static unsigned char *load(const char *path, size_t *len) {
+    FILE *in = fopen(path, "rb");
+    if (in == NULL)
+        return NULL;
+    size_t size = 65536;
+    unsigned char *buf = malloc(size);
+    *len = 0;
+    while (buf != NULL) {
+        *len += fread(buf + *len, 1, size - *len, in);
+        if (*len < size)
+            break;
+        unsigned char *more = realloc(buf, size <<= 1);
+        if (more == NULL)
+            free(buf);
+        buf = more;
+    }
+    if (ferror(in)) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(in);
+    return buf;
+}
+
+// Return the total zlib-compressed length of the messages at level, using
+// the dictionary dict[0..len-1] if len is not zero.
+static size_t total(unsigned char **msg, size_t *lens, size_t count,
+                    int level, const unsigned char *dict, size_t len) {
+    z_stream strm = {0};
+    if (deflateInit(&strm, level) != Z_OK)
+        return 0;
+    unsigned char *out = NULL;
+    uLong room = 0;
+    size_t sum = 0;
+    for (size_t n = 0; n < count; n++) {
+        uLong need = deflateBound(&strm, lens[n]);
+        if (need > room) {
+            free(out);
+            out = malloc(room = need);
+            if (out == NULL)
+                break;
+        }
+        deflateReset(&strm);
+        if (len)
+            deflateSetDictionary(&strm, dict, (uInt)len);
+        strm.next_in = msg[n];
+        strm.avail_in = (uInt)lens[n];
+        strm.next_out = out;
+        strm.avail_out = (uInt)room;
+        deflate(&strm, Z_FINISH);
+        sum += strm.total_out;
+    }
+    free(out);
+    deflateEnd(&strm);
+    return sum;
+}
+
+// Make a dictionary from sample files, and write it to a file. Each sample
+// file is one message, or with -n, each line in the sample files is a
+// message. The size of the dictionary (default 32768) can be set with -s, and
+// the compression level used to show the benefit of the dictionary with -l.
+int main(int argc, char **argv) {
+    size_t size = 32768;
+    int lines = 0, level = Z_DEFAULT_COMPRESSION;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++)
+        if (strcmp(argv[arg], "-n") == 0)
+            lines = 1;
+        else if (strcmp(argv[arg], "-s") == 0 && arg + 1 < argc)
+            size = strtoul(argv[++arg], NULL, 10);
+        else if (strcmp(argv[arg], "-l") == 0 && arg + 1 < argc)
+            level = atoi(argv[++arg]);
+        else
+            break;
+    if (argc - arg < 2 || size == 0 || size > 32768) {
+        fputs("usage: zdict [-n] [-s size] [-l level] dict sample ...\n",
+              stderr);
+        return 1;
+    }
+
+    // load the samples, splitting them into lines if requested
+    size_t count = 0, room = 0;
+    unsigned char **msg = NULL;
+    size_t *lens = NULL;
+    unsigned char **files = calloc(argc, sizeof(unsigned char *));
+    for (int k = arg + 1; k < argc; k++) {
+        size_t len;
+        unsigned char *buf = files[k] = load(argv[k], &len);
+        if (buf == NULL) {
+            fprintf(stderr, "zdict: could not read %s\n", argv[k]);
+            return 1;
+        }
+        while (len) {
+            size_t n = len;
+            if (lines) {
+                unsigned char *eol = memchr(buf, '\n', len);
+                if (eol != NULL)
+                    n = eol - buf + 1;
+            }
+            if (count == room) {
+                room = room ? room << 1 : 1024;
+                msg = realloc(msg, room * sizeof(unsigned char *));
+                lens = realloc(lens, room * sizeof(size_t));
+                if (msg == NULL || lens == NULL) {
+                    fputs("zdict: out of memory\n", stderr);
+                    return 1;
+                }
+            }
+            msg[count] = buf;
+            lens[count++] = n;
+            buf += n;
+            len -= n;
+        }
+    }
+
+    // train and save the dictionary
+    unsigned char *dict = malloc(size);
+    long got = dict == NULL ? -1 :
+               zdict_train(dict, size, (const unsigned char *const *)msg,
+                           lens, count);
+    if (got < 0) {
+        fputs("zdict: out of memory\n", stderr);
+        return 1;
+    }
+    FILE *out = fopen(argv[arg], "wb");
+    if (out == NULL || fwrite(dict, 1, got, out) != (size_t)got ||
+        fclose(out)) {
+        fprintf(stderr, "zdict: could not write %s\n", argv[arg]);
+        return 1;
+    }
+
+    // show the benefit
+    size_t raw = 0;
+    for (size_t n = 0; n < count; n++)
+        raw += lens[n];
+    printf("%zu messages, %zu bytes, %ld byte dictionary\n",
+           count, raw, got);
+    printf("compressed without dictionary: %zu\n",
+           total(msg, lens, count, level, NULL, 0));
+    printf("compressed with dictionary: %zu\n",
+           total(msg, lens, count, level, dict, got));
+
+    free(dict);
+    for (int k = arg + 1; k < argc; k++)
+        free(files[k]);
+    free(files);
+    free(lens);
+    free(msg);
+    return 0;
+}
+
+#endif
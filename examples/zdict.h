@@ -0,0 +1,21 @@
+/* zdict.h -- train a preset dictionary for deflate from sample messages
+ * Copyright (C) 2024 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ * Version 1.0  19 Oct 2026  Mark Adler */
+
+#include <stddef.h>
+
+// Build a preset dictionary of at most size bytes into dict, for compressing
+// messages like the count samples, where sample i is lens[i] bytes at
+// samples[i]. size should be 32768 or less, since deflate can only refer back
+// that far. The dictionary is made of the segments of the samples that contain
+// the most byte strings that are shared by many samples, with the most useful
+// segments at the end of the dictionary, where the distances back to them
+// from the message are the shortest. Return the length of the dictionary,
+// which is less than size if there was not enough useful content in the
+// samples, or -1 if out of memory. The dictionary is used by passing it to
+// deflateSetDictionary() when compressing, and to inflateSetDictionary() when
+// decompressing.
+long zdict_train(unsigned char *dict, size_t size,
+                 const unsigned char *const *samples, const size_t *lens,
+                 size_t count);
@@ -1,7 +1,7 @@
 /* zran.c -- example of deflate stream indexing and random access
  * Copyright (C) 2005, 2012, 2018, 2023, 2024 Mark Adler
  * For conditions of distribution and use, see copyright notice in zlib.h
- * Version 1.5  4 Feb 2024  Mark Adler */
+ * Version 1.6  19 Oct 2026  Mark Adler */
 
 /* Version History:
  1.0  29 May 2005  First version
@@ -18,6 +18,8 @@
                    Stop decoding once request is satisfied
                    Provide a reusable inflate engine in the index
                    Allocate the dictionaries to reduce memory usage
+ 1.6  19 Oct 2026  Add deflate_index_extract_parallel() using threads
+                   Add a NOTHREADS define to not use pthreads or pread()
  */
 
 // Illustrate the use of Z_BLOCK, inflatePrime(), and inflateSetDictionary()
@@ -52,6 +54,14 @@
 // are being accessed, it would make sense to implement a cache to hold some
 // lookahead to avoid many calls to deflate_index_extract() for small lengths.
 //
+// A large request can be extracted faster with multiple threads using
+// deflate_index_extract_parallel(). The request is divided at the access
+// points into segments that can each be decompressed independently. Each
+// thread has its own inflate engine, reads the compressed data with pread(),
+// and decompresses its segments directly into their place in the caller's
+// buffer. This requires pthreads and pread(), and is left out if NOTHREADS is
+// defined.
+//
 // Another way to build an index would be to use inflateCopy(). That would not
 // be constrained to have access points at block boundaries, but would require
 // more memory per access point, and could not be saved to a file due to the
@@ -62,6 +72,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#ifndef NOTHREADS
+#  include <errno.h>
+#  include <unistd.h>
+#  include <pthread.h>
+#endif
 #include "zlib.h"
 #include "zran.h"
 
@@ -337,14 +352,82 @@ static int inflatePreface(z_stream *strm, int bits, int value) {
 #  define INFLATEPRIME inflatePrime
 #endif
 
-// See comments in zran.h.
-ptrdiff_t deflate_index_extract(FILE *in, struct deflate_index *index,
-                                off_t offset, unsigned char *buf, size_t len) {
-    // Do a quick sanity check on the index.
-    if (index == NULL || index->have < 1 || index->list[0].out != 0 ||
-        index->strm.state == Z_NULL)
-        return Z_STREAM_ERROR;
+// Source of compressed input for extraction. If in is not NULL, then input is
+// read sequentially from the stdio stream in. Otherwise input is read from the
+// file descriptor fd with pread() at offset pos, which leaves the file
+// position alone so that several threads can read the same file at once. err
+// is set if there is a read error.
+typedef struct {
+    FILE *in;           // stdio stream, or NULL to use fd
+    int fd;             // file descriptor, if in is NULL
+    off_t pos;          // next offset to read from fd
+    int err;            // true if a read error occurred
+} source_t;
+
+// Position src at offset pos. Return 0 on success or -1 on failure.
+static int source_seek(source_t *src, off_t pos) {
+    if (src->in != NULL)
+        return fseeko(src->in, pos, SEEK_SET);
+    src->pos = pos;
+    return 0;
+}
+
+// Read up to len bytes from src into buf. Return the number of bytes read,
+// which is less than len only at the end of the input or on an error, in which
+// case src->err is set.
+static size_t source_read(source_t *src, unsigned char *buf, size_t len) {
+    if (src->in != NULL) {
+        size_t got = fread(buf, 1, len, src->in);
+        if (got < len && ferror(src->in))
+            src->err = 1;
+        return got;
+    }
+#ifdef NOTHREADS
+    src->err = 1;
+    return 0;
+#else
+    size_t got = 0;
+    while (got < len) {
+        ssize_t ret = pread(src->fd, buf + got, len - got, src->pos);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            src->err = 1;
+            break;
+        }
+        if (ret == 0)
+            break;
+        got += ret;
+        src->pos += ret;
+    }
+    return got;
+#endif
+}
+
+// Return a byte read from src, or EOF at the end of the input or on an error.
+static int source_getc(source_t *src) {
+    unsigned char ch;
+    return source_read(src, &ch, 1) == 1 ? ch : EOF;
+}
+
+// Return true if there is more input in src, without consuming it.
+static int source_more(source_t *src) {
+    if (src->in != NULL)
+        return ungetc(getc(src->in), src->in) != EOF;
+    int ch = source_getc(src);
+    if (ch == EOF)
+        return 0;
+    src->pos--;
+    return 1;
+}
 
+// Use the index to read len bytes from offset into buf, using the inflate
+// engine strm and reading the compressed data from src. This is the common
+// code for deflate_index_extract() and deflate_index_extract_parallel(). strm
+// must have been initialized by inflateInit2().
+static ptrdiff_t extract(source_t *src, z_stream *strm,
+                         struct deflate_index *index, off_t offset,
+                         unsigned char *buf, size_t len) {
     // If nothing to extract, return zero bytes extracted.
     if (len == 0 || offset < 0 || offset >= index->length)
         return 0;
@@ -362,19 +445,19 @@ ptrdiff_t deflate_index_extract(FILE *in, struct deflate_index *index,
     point += lo;
 
     // Initialize the input file and prime the inflate engine to start there.
-    int ret = fseeko(in, point->in - (point->bits ? 1 : 0), SEEK_SET);
+    int ret = source_seek(src, point->in - (point->bits ? 1 : 0));
     if (ret == -1)
         return Z_ERRNO;
     int ch = 0;
-    if (point->bits && (ch = getc(in)) == EOF)
-        return ferror(in) ? Z_ERRNO : Z_BUF_ERROR;
-    index->strm.avail_in = 0;
-    ret = inflateReset2(&index->strm, RAW);
+    if (point->bits && (ch = source_getc(src)) == EOF)
+        return src->err ? Z_ERRNO : Z_BUF_ERROR;
+    strm->avail_in = 0;
+    ret = inflateReset2(strm, RAW);
     if (ret != Z_OK)
         return ret;
     if (point->bits)
-        INFLATEPRIME(&index->strm, point->bits, ch >> (8 - point->bits));
-    inflateSetDictionary(&index->strm, point->window, point->dict);
+        INFLATEPRIME(strm, point->bits, ch >> (8 - point->bits));
+    inflateSetDictionary(strm, point->window, point->dict);
 
     // Skip uncompressed bytes until offset reached, then satisfy request.
     unsigned char input[CHUNK];
@@ -384,30 +467,28 @@ ptrdiff_t deflate_index_extract(FILE *in, struct deflate_index *index,
     do {
         if (offset) {
             // Discard up to offset uncompressed bytes.
-            index->strm.avail_out = offset < WINSIZE ? (unsigned)offset :
-                                                       WINSIZE;
-            index->strm.next_out = discard;
+            strm->avail_out = offset < WINSIZE ? (unsigned)offset : WINSIZE;
+            strm->next_out = discard;
         }
         else {
             // Uncompress up to left bytes into buf.
-            index->strm.avail_out = left < UINT_MAX ? (unsigned)left :
-                                                      UINT_MAX;
-            index->strm.next_out = buf + len - left;
+            strm->avail_out = left < UINT_MAX ? (unsigned)left : UINT_MAX;
+            strm->next_out = buf + len - left;
         }
 
         // Uncompress, setting got to the number of bytes uncompressed.
-        if (index->strm.avail_in == 0) {
+        if (strm->avail_in == 0) {
             // Assure available input.
-            index->strm.avail_in = fread(input, 1, CHUNK, in);
-            if (index->strm.avail_in < CHUNK && ferror(in)) {
+            strm->avail_in = source_read(src, input, CHUNK);
+            if (src->err) {
                 ret = Z_ERRNO;
                 break;
             }
-            index->strm.next_in = input;
+            strm->next_in = input;
         }
-        unsigned got = index->strm.avail_out;
-        ret = inflate(&index->strm, Z_NO_FLUSH);
-        got -= index->strm.avail_out;
+        unsigned got = strm->avail_out;
+        ret = inflate(strm, Z_NO_FLUSH);
+        got -= strm->avail_out;
 
         // Update the appropriate count.
         if (offset)
@@ -424,41 +505,41 @@ ptrdiff_t deflate_index_extract(FILE *in, struct deflate_index *index,
         if (ret == Z_STREAM_END && index->mode == GZIP) {
             // Discard the gzip trailer.
             unsigned drop = 8;              // length of gzip trailer
-            if (index->strm.avail_in >= drop) {
-                index->strm.avail_in -= drop;
-                index->strm.next_in += drop;
+            if (strm->avail_in >= drop) {
+                strm->avail_in -= drop;
+                strm->next_in += drop;
             }
             else {
                 // Read and discard the remainder of the gzip trailer.
-                drop -= index->strm.avail_in;
-                index->strm.avail_in = 0;
+                drop -= strm->avail_in;
+                strm->avail_in = 0;
                 do {
-                    if (getc(in) == EOF)
+                    if (source_getc(src) == EOF)
                         // The input does not have a complete trailer.
-                        return ferror(in) ? Z_ERRNO : Z_BUF_ERROR;
+                        return src->err ? Z_ERRNO : Z_BUF_ERROR;
                 } while (--drop);
             }
 
-            if (index->strm.avail_in || ungetc(getc(in), in) != EOF) {
+            if (strm->avail_in || source_more(src)) {
                 // There's more after the gzip trailer. Use inflate to skip the
                 // gzip header and resume the raw inflate there.
-                inflateReset2(&index->strm, GZIP);
+                inflateReset2(strm, GZIP);
                 do {
-                    if (index->strm.avail_in == 0) {
-                        index->strm.avail_in = fread(input, 1, CHUNK, in);
-                        if (index->strm.avail_in < CHUNK && ferror(in)) {
+                    if (strm->avail_in == 0) {
+                        strm->avail_in = source_read(src, input, CHUNK);
+                        if (src->err) {
                             ret = Z_ERRNO;
                             break;
                         }
-                        index->strm.next_in = input;
+                        strm->next_in = input;
                     }
-                    index->strm.avail_out = WINSIZE;
-                    index->strm.next_out = discard;
-                    ret = inflate(&index->strm, Z_BLOCK);  // stop after header
-                } while (ret == Z_OK && (index->strm.data_type & 0x80) == 0);
+                    strm->avail_out = WINSIZE;
+                    strm->next_out = discard;
+                    ret = inflate(strm, Z_BLOCK);  // stop after header
+                } while (ret == Z_OK && (strm->data_type & 0x80) == 0);
                 if (ret != Z_OK)
                     break;
-                inflateReset2(&index->strm, RAW);
+                inflateReset2(strm, RAW);
             }
         }
 
@@ -470,10 +551,141 @@ ptrdiff_t deflate_index_extract(FILE *in, struct deflate_index *index,
     return ret == Z_OK || ret == Z_STREAM_END ? len - left : ret;
 }
 
+// See comments in zran.h.
+ptrdiff_t deflate_index_extract(FILE *in, struct deflate_index *index,
+                                off_t offset, unsigned char *buf, size_t len) {
+    // Do a quick sanity check on the index.
+    if (index == NULL || index->have < 1 || index->list[0].out != 0 ||
+        index->strm.state == Z_NULL)
+        return Z_STREAM_ERROR;
+
+    // Extract using the inflate engine in the index.
+    source_t src = {in, -1, 0, 0};
+    return extract(&src, &index->strm, index, offset, buf, len);
+}
+
+#ifndef NOTHREADS
+
+// Work shared by the threads of deflate_index_extract_parallel(). The request
+// is divided into segments at the access points. Segment 0 starts at offset,
+// and segment k > 0 starts at the access point first + k. Each thread takes
+// the next segment not yet taken, until they are all done or there's an error.
+struct extract_job {
+    struct deflate_index *index;    // the index
+    int fd;                 // file descriptor for the compressed data
+    off_t offset;           // uncompressed offset of the request
+    unsigned char *buf;     // where to put the request
+    size_t len;             // length of the request
+    int first;              // access point at or before offset
+    int segs;               // number of segments
+    int next;               // next segment to take
+    int ret;                // first error encountered, or Z_OK
+    pthread_mutex_t lock;   // protects next and ret
+};
+
+// Extract segments of job until there are none left. This is run by each of
+// the threads, with its own inflate engine.
+static void *extract_worker(void *arg) {
+    struct extract_job *job = arg;
+    z_stream strm;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.avail_in = 0;
+    strm.next_in = Z_NULL;
+    int ret = inflateInit2(&strm, RAW);
+    for (;;) {
+        // Take the next segment, or stop if there is nothing left to do.
+        pthread_mutex_lock(&job->lock);
+        if (ret != Z_OK && job->ret == Z_OK)
+            job->ret = ret;
+        int seg = job->ret == Z_OK && job->next < job->segs ? job->next++ :
+                                                              -1;
+        pthread_mutex_unlock(&job->lock);
+        if (seg == -1)
+            break;
+
+        // Extract the segment directly into its place in buf.
+        point_t *list = job->index->list;
+        off_t beg = seg ? list[job->first + seg].out : job->offset;
+        off_t end = seg + 1 < job->segs ? list[job->first + seg + 1].out :
+                                          job->offset + (off_t)job->len;
+        source_t src = {NULL, job->fd, 0, 0};
+        ptrdiff_t got = extract(&src, &strm, job->index, beg,
+                                job->buf + (beg - job->offset), end - beg);
+        ret = got < 0 ? (int)got : got < end - beg ? Z_BUF_ERROR : Z_OK;
+    }
+    inflateEnd(&strm);
+    return NULL;
+}
+
+// See comments in zran.h.
+ptrdiff_t deflate_index_extract_parallel(FILE *in,
+                                         struct deflate_index *index,
+                                         off_t offset, unsigned char *buf,
+                                         size_t len, int threads) {
+    // Do a quick sanity check on the index.
+    if (index == NULL || index->have < 1 || index->list[0].out != 0)
+        return Z_STREAM_ERROR;
+
+    // If nothing to extract, return zero bytes extracted. Otherwise limit the
+    // request to the uncompressed data.
+    if (len == 0 || offset < 0 || offset >= index->length)
+        return 0;
+    if ((off_t)len > index->length - offset)
+        len = index->length - offset;
+
+    // Divide the request into segments at the access points.
+    struct extract_job job;
+    job.index = index;
+    job.fd = fileno(in);
+    job.offset = offset;
+    job.buf = buf;
+    job.len = len;
+    int lo = -1, hi = index->have;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) >> 1;
+        if (offset < index->list[mid].out)
+            hi = mid;
+        else
+            lo = mid;
+    }
+    job.first = lo;
+    while (hi < index->have && index->list[hi].out < offset + (off_t)len)
+        hi++;
+    job.segs = hi - lo;
+    job.next = 0;
+    job.ret = Z_OK;
+    pthread_mutex_init(&job.lock, NULL);
+
+    // Start up to threads - 1 threads, and do the extraction with them and
+    // this thread. If a thread can't be started, go with what we have.
+    if (threads > job.segs)
+        threads = job.segs;
+    pthread_t *pool = NULL;
+    int started = 0;
+    if (threads > 1 && (pool = malloc((threads - 1) * sizeof(pthread_t))) !=
+                       NULL)
+        while (started < threads - 1 &&
+               pthread_create(pool + started, NULL, extract_worker, &job) == 0)
+            started++;
+    extract_worker(&job);
+    while (started)
+        pthread_join(pool[--started], NULL);
+    free(pool);
+    pthread_mutex_destroy(&job.lock);
+
+    // Return the number of uncompressed bytes read into buf, or the error.
+    return job.ret == Z_OK ? (ptrdiff_t)len : job.ret;
+}
+
+#endif
+
 #ifdef TEST
 
 #define SPAN 1048576L       // desired distance between access points
 #define LEN 16384           // number of bytes to extract
+#define THREADS 4           // number of threads for parallel extraction
 
 // Demonstrate the use of deflate_index_build() and deflate_index_extract() by
 // processing the file provided on the command line, and extracting LEN bytes
@@ -541,6 +753,26 @@ int main(int argc, char **argv) {
         fprintf(stderr, "zran: extracted %ld bytes at %lld\n", got, offset);
     }
 
+#ifndef NOTHREADS
+    // Extract all of the uncompressed data using several threads, and check
+    // that it agrees with what was extracted above.
+    unsigned char *all = malloc(index->length ? index->length : 1);
+    if (all == NULL)
+        fprintf(stderr, "zran: out of memory for parallel extraction\n");
+    else {
+        ptrdiff_t total = deflate_index_extract_parallel(in, index, 0, all,
+                                                         index->length,
+                                                         THREADS);
+        if (total != index->length ||
+            (got > 0 && memcmp(all + offset, buf, got)))
+            fprintf(stderr, "zran: parallel extraction failed\n");
+        else
+            fprintf(stderr, "zran: extracted %ld bytes with %d threads\n",
+                    total, THREADS);
+        free(all);
+    }
+#endif
+
     // Clean up and exit.
     deflate_index_free(index);
     fclose(in);
@@ -1,7 +1,7 @@
 /* zran.h -- example of deflated stream indexing and random access
  * Copyright (C) 2005, 2012, 2018, 2023, 2024 Mark Adler
  * For conditions of distribution and use, see copyright notice in zlib.h
- * Version 1.5  4 Feb 2024  Mark Adler */
+ * Version 1.6  19 Oct 2026  Mark Adler */
 
 #include <stdio.h>
 #include "zlib.h"
@@ -49,5 +49,19 @@ int deflate_index_build(FILE *in, off_t span, struct deflate_index **built);
 ptrdiff_t deflate_index_extract(FILE *in, struct deflate_index *index,
                                 off_t offset, unsigned char *buf, size_t len);
 
+// Like deflate_index_extract(), but divide the request at the access points
+// and decompress the pieces with up to threads threads at once, each with its
+// own inflate engine. The compressed data is read from fileno(in) using
+// pread(), so the position of in is not used or changed. index->strm is not
+// used either, so deflate_index_extract_parallel() can be called from several
+// threads at once with the same index and file. This is only of benefit when
+// len spans several access points. The return value is the same as for
+// deflate_index_extract(). This is not available if zran.c is compiled with
+// NOTHREADS defined.
+ptrdiff_t deflate_index_extract_parallel(FILE *in,
+                                         struct deflate_index *index,
+                                         off_t offset, unsigned char *buf,
+                                         size_t len, int threads);
+
 // Deallocate an index built by deflate_index_build().
 void deflate_index_free(struct deflate_index *index);
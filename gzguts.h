@@ -151,6 +151,32 @@
 #  define DEF_MEM_LEVEL  MAX_MEM_LEVEL
 #endif
 
+/* lseek() that can handle large offsets */
+#if defined(__DJGPP__)
+#  define LSEEK llseek
+#elif defined(_WIN32) && !defined(__BORLANDC__) && !defined(UNDER_CE)
+#  define LSEEK _lseeki64
+#elif defined(_LARGEFILE64_SOURCE) && _LFS64_LARGEFILE-0
+#  define LSEEK lseek64
+#else
+#  define LSEEK lseek
+#endif
+
+/* pread() that can handle large offsets, if pread() is declared, which
+   unistd.h indicates with the POSIX or X/Open version (pread64() is declared
+   along with pread() when _LARGEFILE64_SOURCE is defined) */
+#if !defined(NO_PREAD) && !(defined(_POSIX_VERSION) && \
+    (_POSIX_VERSION-0 >= 200809L || _XOPEN_VERSION-0 >= 500))
+#  define NO_PREAD
+#endif
+#ifndef NO_PREAD
+#  if defined(_LARGEFILE64_SOURCE) && _LFS64_LARGEFILE-0
+#    define PREAD pread64
+#  else
+#    define PREAD pread
+#  endif
+#endif
+
 /* default i/o buffer size -- double this for output when reading (this and
    twice this must be able to fit in an unsigned type) */
 #define GZBUFSIZE 8192
@@ -166,6 +192,39 @@
 #define COPY 1      /* copy input directly */
 #define GZIP 2      /* decompress a gzip stream */
 
+/* access point for resuming decompression in the middle of a gzip member */
+typedef struct {
+    z_off64_t out;          /* offset in uncompressed data */
+    z_off64_t in;           /* offset in file of first full compressed byte */
+    int bits;               /* 0, or number of bits (1-7) from byte at in-1 */
+    z_off64_t beg;          /* uncompressed offset of the member's start */
+    unsigned long check;    /* CRC-32 of the member data from beg to out */
+    unsigned dict;          /* number of bytes in window */
+    unsigned zlen;          /* length of window as raw deflate, 0 if stored */
+    unsigned char *window;  /* up to 32K of uncompressed data preceding out */
+} gz_point;
+
+/* index file format, see gzsaveindex() */
+#define GZ_INDEX_SUFFIX ".zri"     /* file name suffix of a sidecar index */
+#define GZ_INDEX_MAGIC "gzix"      /* first four bytes of an index file */
+#define GZ_INDEX_VERSION 1         /* fifth byte of an index file */
+#define GZ_INDEX_HEAD 17           /* length of the index file header */
+#define GZ_INDEX_POINT 37          /* length of an access point, less window */
+
+/* BGZF blocked gzip format -- gzip members of at most BGZF_MAX bytes, each
+   with an 18-byte header that has a "BC" extra field giving the member size */
+#define BGZF_MAX 65536             /* maximum size of a BGZF member */
+#define BGZF_HEAD 18               /* length of a BGZF member header */
+#define BGZF_BLOCK 65280           /* uncompressed data written per member */
+
+/* rsyncable writing -- a full flush is done after the input bytes where a
+   hash of the last RSYNC_BITS bytes is RSYNC_HIT, so on average every
+   2^RSYNC_BITS bytes, but no closer than RSYNC_MIN bytes to the last one */
+#define RSYNC_BITS 16
+#define RSYNC_MASK ((1U << RSYNC_BITS) - 1)
+#define RSYNC_HIT (RSYNC_MASK >> 1)
+#define RSYNC_MIN 4096
+
 /* internal gzip file state data structure */
 typedef struct {
         /* exposed contents for gzgetc() macro */
@@ -182,15 +241,32 @@ typedef struct {
     unsigned char *in;      /* input buffer (double-sized when writing) */
     unsigned char *out;     /* output buffer (double-sized when reading) */
     int direct;             /* 0 if processing gzip, 1 if transparent */
+    int bgzf;               /* true if writing BGZF members */
+    z_off64_t block;        /* file offset of the current or next member */
+    z_off64_t start;        /* where the gzip data started, for rewinding */
+    z_off64_t beg;          /* uncompressed offset of current gzip member */
         /* just for reading */
     int how;                /* 0: get header, 1: copy, 2: decompress */
-    z_off64_t start;        /* where the gzip data started, for rewinding */
     int eof;                /* true if end of input file reached */
     int past;               /* true if read requested past end */
+    z_off64_t raw;          /* file offset just after data read into in */
+    int resume;             /* true if inflating raw from an access point */
+    unsigned long check;    /* running CRC-32 of member data when resumed */
+    unsigned char *line;    /* lines that span buffers for gzgetline() */
+    z_size_t lsize;         /* allocated size of line, zero if none */
+        /* access points for seeking, built while reading or writing */
+    z_off64_t span;         /* minimum distance between points, 0 for none */
+    gz_point *list;         /* access points in increasing offset order */
+    int points;             /* number of access points in list */
+    int room;               /* number of access points allocated */
+    int sidecar;            /* true to use an index file next to the file */
         /* just for writing */
     int level;              /* compression level */
     int strategy;           /* compression strategy */
     int reset;              /* true if a reset is pending after a Z_FINISH */
+    int rsync;              /* true to flush at content-defined points */
+    unsigned rhash;         /* rolling hash of the most recent input bytes */
+    unsigned rgap;          /* input bytes since the last rsync flush */
         /* seek request */
     z_off64_t skip;         /* amount to skip (already rewound if backwards) */
     int seek;               /* true if seek request pending */
@@ -204,6 +280,9 @@ typedef gz_state FAR *gz_statep;
 
 /* shared functions */
 void ZLIB_INTERNAL gz_error(gz_statep, int, const char *);
+void ZLIB_INTERNAL gz_unindex(gz_statep);
+char ZLIB_INTERNAL *gz_sidecar(gz_statep);
+int ZLIB_INTERNAL gz_write_index(gz_statep, const char *);
 #if defined UNDER_CE
 char ZLIB_INTERNAL *gz_strwinerror(DWORD error);
 #endif
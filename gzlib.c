@@ -5,16 +5,6 @@
 
 #include "gzguts.h"
 
-#if defined(__DJGPP__)
-#  define LSEEK llseek
-#elif defined(_WIN32) && !defined(__BORLANDC__) && !defined(UNDER_CE)
-#  define LSEEK _lseeki64
-#elif defined(_LARGEFILE64_SOURCE) && _LFS64_LARGEFILE-0
-#  define LSEEK lseek64
-#else
-#  define LSEEK lseek
-#endif
-
 #if defined UNDER_CE
 
 /* Map the Windows error number in ERROR to a locale-dependent error message
@@ -72,9 +62,14 @@ local void gz_reset(gz_statep state) {
         state->eof = 0;             /* not at end of file */
         state->past = 0;            /* have not read past end yet */
         state->how = LOOK;          /* look for gzip header */
+        state->raw = state->start;  /* file offset of next read */
+        state->block = state->start;    /* first member starts here */
+        state->beg = 0;
     }
-    else                            /* for writing ... */
+    else {                          /* for writing ... */
         state->reset = 0;           /* no deflateReset pending */
+        state->beg = 0;
+    }
     state->seek = 0;                /* no seek request pending */
     gz_error(state, Z_OK, NULL);    /* clear error */
     state->x.pos = 0;               /* no uncompressed data yet */
@@ -110,6 +105,18 @@ local gzFile gz_open(const void *path, int fd, const char *mode) {
     state->level = Z_DEFAULT_COMPRESSION;
     state->strategy = Z_DEFAULT_STRATEGY;
     state->direct = 0;
+    state->bgzf = 0;
+    state->rsync = 0;
+    state->rhash = 0;
+    state->rgap = 0;
+    state->resume = 0;
+    state->line = NULL;
+    state->lsize = 0;
+    state->span = 0;            /* no access points */
+    state->list = NULL;
+    state->points = 0;
+    state->room = 0;
+    state->sidecar = 0;
     while (*mode) {
         if (*mode >= '0' && *mode <= '9')
             state->level = *mode - '0';
@@ -156,6 +163,15 @@ local gzFile gz_open(const void *path, int fd, const char *mode) {
             case 'T':
                 state->direct = 1;
                 break;
+            case 'i':
+                state->sidecar = fd != -1 && fd != -2 ? 0 : 1;
+                break;
+            case 'B':
+                state->bgzf = 1;
+                break;
+            case 'y':
+                state->rsync = 1;
+                break;
             default:        /* could consider as an error, but just ignore */
                 ;
             }
@@ -246,10 +262,25 @@ local gzFile gz_open(const void *path, int fd, const char *mode) {
         state->mode = GZ_WRITE;         /* simplify later checks */
     }
 
+    /* save where the first member will go for BGZF virtual offsets, and
+       for the access points of an index built while writing */
+    if (state->mode == GZ_WRITE) {
+        state->block = LSEEK(state->fd, 0, SEEK_CUR);
+        if (state->block == -1) state->block = 0;
+        state->start = state->block;
+    }
+
     /* save the current position for rewinding (only if reading) */
     if (state->mode == GZ_READ) {
         state->start = LSEEK(state->fd, 0, SEEK_CUR);
         if (state->start == -1) state->start = 0;
+#ifdef POSIX_FADV_SEQUENTIAL
+        /* reading is almost always front to back -- let the system read
+           ahead further, so that a cold file is not read one buffer at a time
+           (the return value is ignored, since this is only advice, and fails
+           on pipes) */
+        (void)posix_fadvise(state->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
     }
 
     /* initialize stream */
@@ -317,6 +348,29 @@ int ZEXPORT gzbuffer(gzFile file, unsigned size) {
     return 0;
 }
 
+/* -- see zlib.h -- */
+int ZEXPORT gzindex(gzFile file, z_off64_t span) {
+    gz_statep state;
+
+    /* get internal structure and check integrity */
+    if (file == NULL)
+        return -1;
+    state = (gz_statep)file;
+    if (state->mode != GZ_READ && state->mode != GZ_WRITE)
+        return -1;
+
+    /* when writing, the uncompressed offsets of the access points are only
+       known if the file is being written from the start, and compressed */
+    if (state->mode == GZ_WRITE && (state->start != 0 || state->direct))
+        return -1;
+
+    /* check and set requested spacing */
+    if (span < 0)
+        return -1;
+    state->span = span;
+    return 0;
+}
+
 /* -- see zlib.h -- */
 int ZEXPORT gzrewind(gzFile file) {
     gz_statep state;
@@ -471,6 +525,79 @@ z_off_t ZEXPORT gzoffset(gzFile file) {
     return ret == (z_off_t)ret ? (z_off_t)ret : -1;
 }
 
+/* -- see zlib.h -- */
+z_off64_t ZEXPORT gzvtell(gzFile file) {
+    z_off64_t within;
+    gz_statep state;
+
+    /* get internal structure and check integrity */
+    if (file == NULL)
+        return -1;
+    state = (gz_statep)file;
+
+    /* get the offset in the current member, which for writing is what has
+       been written to the pending member, or for reading is how far into the
+       last member decompressed -- in either case, include a pending seek only
+       if it doesn't leave the member */
+    if (state->mode == GZ_WRITE) {
+        if (!state->bgzf || state->direct)
+            return -1;
+        within = (z_off64_t)state->strm.avail_in +
+                 (state->seek ? state->skip : 0);
+        if (within > BGZF_BLOCK)
+            return -1;
+    }
+    else if (state->mode == GZ_READ) {
+        if (state->how == COPY ||
+                (state->seek && state->skip > (z_off64_t)state->x.have))
+            return -1;
+        within = state->x.pos - state->beg + (state->seek ? state->skip : 0);
+        if (within > 0xffff)
+            return -1;
+    }
+    else
+        return -1;
+
+    /* return the virtual offset */
+    if (state->block >= ((z_off64_t)1 << (sizeof(z_off64_t) * 8 - 17)))
+        return -1;
+    return (state->block << 16) + within;
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzvseek(gzFile file, z_off64_t offset) {
+    gz_statep state;
+
+    /* get internal structure and check integrity */
+    if (file == NULL || offset < 0)
+        return -1;
+    state = (gz_statep)file;
+
+    /* check that we're reading gzip data and that there's no error */
+    if (state->mode != GZ_READ || state->how == COPY ||
+            (state->err != Z_OK && state->err != Z_BUF_ERROR))
+        return -1;
+
+    /* go to the member, and start decoding there with an unknown position in
+       the uncompressed data -- the access points, and any sidecar index, can
+       no longer be used */
+    if (LSEEK(state->fd, offset >> 16, SEEK_SET) == -1)
+        return -1;
+    gz_reset(state);
+    gz_unindex(state);
+    state->span = 0;
+    state->sidecar = 0;
+    state->raw = state->block = offset >> 16;
+    state->direct = 0;
+
+    /* skip to the offset in the member on the next read */
+    if (offset & 0xffff) {
+        state->seek = 1;
+        state->skip = offset & 0xffff;
+    }
+    return 0;
+}
+
 /* -- see zlib.h -- */
 int ZEXPORT gzeof(gzFile file) {
     gz_statep state;
@@ -566,6 +693,33 @@ void ZLIB_INTERNAL gz_error(gz_statep state, int err, const char *msg) {
 #endif
 }
 
+/* Free the access points in the index. */
+void ZLIB_INTERNAL gz_unindex(gz_statep state) {
+    while (state->points)
+        free(state->list[--state->points].window);
+    free(state->list);
+    state->list = NULL;
+    state->room = 0;
+}
+
+/* Return the path of the sidecar index for the file in allocated memory, or
+   NULL if out of memory. */
+char ZLIB_INTERNAL *gz_sidecar(gz_statep state) {
+    char *path;
+    z_size_t len = strlen(state->path) + sizeof(GZ_INDEX_SUFFIX);
+
+    path = (char *)malloc(len);
+    if (path == NULL)
+        return NULL;
+#if !defined(NO_snprintf) && !defined(NO_vsnprintf)
+    (void)snprintf(path, len, "%s%s", state->path, GZ_INDEX_SUFFIX);
+#else
+    strcpy(path, state->path);
+    strcat(path, GZ_INDEX_SUFFIX);
+#endif
+    return path;
+}
+
 /* portably return maximum value for an int (when limits.h presumed not
    available) -- we need to do this to cover cases where 2's complement not
    used, since C standard permits 1's complement and sign-bit representations,
@@ -24,6 +24,7 @@ local int gz_load(gz_statep state, unsigned char *buf, unsigned len,
             break;
         *have += (unsigned)ret;
     } while (*have < len);
+    state->raw += *have;
     if (ret < 0) {
         gz_error(state, Z_ERRNO, zstrerror());
         return -1;
@@ -64,6 +65,253 @@ local int gz_avail(gz_statep state) {
     return 0;
 }
 
+/* Return the n-byte little-endian integer at buf, or -1 if it does not fit in
+   a z_off64_t. */
+local z_off64_t gz_get(const unsigned char *buf, int n) {
+    z_off64_t val = 0;
+
+    if (n == 8 && buf[7] > 0x7f)
+        return -1;
+    while (n--)
+        val = (val << 8) + buf[n];
+    return val;
+}
+
+/* Store val in buf as an n-byte little-endian integer. */
+local void gz_put(unsigned char *buf, z_off64_t val, int n) {
+    while (n--) {
+        *buf++ = (unsigned char)val;
+        val >>= 8;
+    }
+}
+
+/* Write len bytes from buf to fd.  Return -1 on error, otherwise 0. */
+local int gz_send(int fd, const unsigned char *buf, unsigned len) {
+    int writ;
+
+    while (len) {
+        writ = write(fd, buf, len > 65536U ? 65536U : len);
+        if (writ <= 0)
+            return -1;
+        buf += writ;
+        len -= (unsigned)writ;
+    }
+    return 0;
+}
+
+/* Replace the index of state with the one in the index file at path, in the
+   format written by gzsaveindex().  The windows are left compressed until they
+   are needed.  Return Z_OK on success, Z_ERRNO if the index file could not be
+   opened or read, Z_DATA_ERROR if it is not a valid index for this file, or
+   Z_MEM_ERROR if out of memory.  The state's error is not changed. */
+local int gz_read_index(gz_statep state, const char *path) {
+    int fd, ret, n, points;
+    unsigned char *buf, *next, *end;
+    z_off64_t len, cur, size, got, count;
+    gz_point *list, *point;
+
+    /* read the entire index file */
+    fd = open(path, O_RDONLY
+#ifdef O_BINARY
+                  | O_BINARY
+#endif
+              );
+    if (fd == -1)
+        return Z_ERRNO;
+    len = LSEEK(fd, 0, SEEK_END);
+    if (len < GZ_INDEX_HEAD || LSEEK(fd, 0, SEEK_SET) == -1 ||
+            (z_off64_t)(z_size_t)len != len) {
+        close(fd);
+        return len < GZ_INDEX_HEAD && len != -1 ? Z_DATA_ERROR : Z_ERRNO;
+    }
+    buf = (unsigned char *)malloc((z_size_t)len);
+    if (buf == NULL) {
+        close(fd);
+        return Z_MEM_ERROR;
+    }
+    got = 0;
+    do {
+        n = len - got > 65536 ? 65536 : (int)(len - got);
+        ret = read(fd, buf + got, n);
+        if (ret <= 0)
+            break;
+        got += ret;
+    } while (got < len);
+    close(fd);
+    if (got < len) {
+        free(buf);
+        return Z_ERRNO;
+    }
+
+    /* check the header, and that the index was made for a file of this size
+       (restoring the file position after getting the size) */
+    cur = LSEEK(state->fd, 0, SEEK_CUR);
+    size = LSEEK(state->fd, 0, SEEK_END);
+    if (cur == -1 || size == -1 || LSEEK(state->fd, cur, SEEK_SET) == -1) {
+        free(buf);
+        return Z_ERRNO;
+    }
+    count = gz_get(buf + 13, 4);
+    if (memcmp(buf, GZ_INDEX_MAGIC, 4) || buf[4] != GZ_INDEX_VERSION ||
+            gz_get(buf + 5, 8) != size || count > (z_off64_t)gz_intmax() ||
+            count > (len - GZ_INDEX_HEAD) / GZ_INDEX_POINT) {
+        free(buf);
+        return Z_DATA_ERROR;
+    }
+    points = (int)count;
+
+    /* decode and check the access points */
+    list = (gz_point *)malloc(sizeof(gz_point) * (points ? points : 1));
+    if (list == NULL) {
+        free(buf);
+        return Z_MEM_ERROR;
+    }
+    next = buf + GZ_INDEX_HEAD;
+    end = buf + len;
+    ret = Z_OK;
+    for (n = 0; n < points; n++) {
+        point = list + n;
+        if (end - next < GZ_INDEX_POINT) {
+            ret = Z_DATA_ERROR;
+            break;
+        }
+        point->window = NULL;
+        point->out = gz_get(next, 8);
+        point->in = gz_get(next + 8, 8);
+        point->beg = gz_get(next + 16, 8);
+        point->check = (unsigned long)gz_get(next + 24, 4);
+        point->bits = next[28];
+        point->dict = (unsigned)gz_get(next + 29, 4);
+        point->zlen = (unsigned)gz_get(next + 33, 4);
+        next += GZ_INDEX_POINT;
+        if (point->out < 0 || point->in < 0 || point->beg < 0 ||
+                point->beg > point->out || point->bits > 7 ||
+                point->dict > 32768U ||
+                (point->dict == 0) != (point->zlen == 0) ||
+                (n && point->out <= point[-1].out) ||
+                (z_off64_t)(end - next) < (z_off64_t)point->zlen) {
+            ret = Z_DATA_ERROR;
+            break;
+        }
+        if (point->zlen) {
+            point->window = (unsigned char *)malloc(point->zlen);
+            if (point->window == NULL) {
+                ret = Z_MEM_ERROR;
+                break;
+            }
+            memcpy(point->window, next, point->zlen);
+            next += point->zlen;
+        }
+    }
+    free(buf);
+    if (ret == Z_OK && next != end)
+        ret = Z_DATA_ERROR;
+    if (ret != Z_OK) {
+        while (n > 0)
+            free(list[--n].window);
+        free(list);
+        return ret;
+    }
+
+    /* replace the index */
+    gz_unindex(state);
+    state->list = list;
+    state->points = points;
+    state->room = points ? points : 1;
+    return Z_OK;
+}
+
+/* Write the index of state to the file at path, with the windows compressed as
+   raw deflate data.  All integers are little-endian.  The header is the four
+   bytes "gzix", a version byte of 1, the eight-byte length of the compressed
+   file, so that an index for some other file is not used, and the four-byte
+   number of access points.  Each access point is then the eight-byte
+   uncompressed offset, the eight-byte offset of the first full byte in the
+   compressed file, the eight-byte uncompressed offset of the start of the
+   gzip member, the four-byte CRC-32 of the member data up to the access point,
+   a byte with the number of bits to use from the preceding byte, the four-byte
+   length of the window, and the four-byte length of the compressed window,
+   followed by the compressed window.  A window of length zero is not stored.
+   Return Z_OK on success, Z_ERRNO on a file error, or Z_MEM_ERROR if out of
+   memory.  The state's error is not changed. */
+int ZLIB_INTERNAL gz_write_index(gz_statep state, const char *path) {
+    int fd, ret, n;
+    unsigned zlen;
+    unsigned char *buf, *win;
+    unsigned char head[GZ_INDEX_POINT];     /* also holds the header */
+    z_off64_t cur, size;
+    z_stream strm;
+    gz_point *point;
+
+    /* get the length of the compressed file, restoring the position */
+    cur = LSEEK(state->fd, 0, SEEK_CUR);
+    size = LSEEK(state->fd, 0, SEEK_END);
+    if (cur == -1 || size == -1 || LSEEK(state->fd, cur, SEEK_SET) == -1)
+        return Z_ERRNO;
+
+    /* set up for compressing windows */
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    if (deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, -15,
+                     DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+        return Z_MEM_ERROR;
+    buf = (unsigned char *)malloc(deflateBound(&strm, 32768U));
+    if (buf == NULL) {
+        deflateEnd(&strm);
+        return Z_MEM_ERROR;
+    }
+
+    /* write the header and the access points */
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC
+#ifdef O_BINARY
+                    | O_BINARY
+#endif
+              , 0666);
+    ret = fd == -1 ? Z_ERRNO : Z_OK;
+    if (ret == Z_OK) {
+        memcpy(head, GZ_INDEX_MAGIC, 4);
+        head[4] = GZ_INDEX_VERSION;
+        gz_put(head + 5, size, 8);
+        gz_put(head + 13, state->points, 4);
+        if (gz_send(fd, head, GZ_INDEX_HEAD) == -1)
+            ret = Z_ERRNO;
+    }
+    for (n = 0; ret == Z_OK && n < state->points; n++) {
+        /* compress the window if it isn't already */
+        point = state->list + n;
+        win = point->window;
+        zlen = point->zlen;
+        if (point->dict && zlen == 0) {
+            deflateReset(&strm);
+            strm.next_in = point->window;
+            strm.avail_in = point->dict;
+            strm.next_out = buf;
+            strm.avail_out = (uInt)deflateBound(&strm, point->dict);
+            (void)deflate(&strm, Z_FINISH);
+            win = buf;
+            zlen = (unsigned)strm.total_out;
+        }
+
+        /* write the access point and its window */
+        gz_put(head, point->out, 8);
+        gz_put(head + 8, point->in, 8);
+        gz_put(head + 16, point->beg, 8);
+        gz_put(head + 24, (z_off64_t)point->check, 4);
+        head[28] = (unsigned char)point->bits;
+        gz_put(head + 29, point->dict, 4);
+        gz_put(head + 33, zlen, 4);
+        if (gz_send(fd, head, GZ_INDEX_POINT) == -1 ||
+                gz_send(fd, win, zlen) == -1)
+            ret = Z_ERRNO;
+    }
+    if (fd != -1 && close(fd) == -1)
+        ret = Z_ERRNO;
+    free(buf);
+    deflateEnd(&strm);
+    return ret;
+}
+
 /* Look for gzip header, set up for inflate or copy.  state->x.have must be 0.
    If this is the first time in, allocate required memory.  state->how will be
    left unchanged if there is no more input data available, will be set to COPY
@@ -102,6 +350,15 @@ local int gz_look(gz_statep state) {
             gz_error(state, Z_MEM_ERROR, "out of memory");
             return -1;
         }
+
+        /* use the sidecar index if requested and there is a usable one */
+        if (state->sidecar) {
+            char *path = gz_sidecar(state);
+            if (path != NULL) {
+                (void)gz_read_index(state, path);
+                free(path);
+            }
+        }
     }
 
     /* get at least the magic bytes in the input buffer */
@@ -121,7 +378,38 @@ local int gz_look(gz_statep state) {
        single byte is sufficient indication that it is not a gzip file) */
     if (strm->avail_in > 1 &&
             strm->next_in[0] == 31 && strm->next_in[1] == 139) {
-        inflateReset(strm);
+        state->block = state->raw - strm->avail_in;
+
+        /* a BGZF member has a fixed header, which can be skipped here, with
+           inflate just resetting its raw decoding for the deflate data -- the
+           check value is then computed here as for an access point (the
+           header is only used if it is all in the input buffer) */
+        if (strm->avail_in < BGZF_HEAD && !state->eof &&
+                gz_avail(state) == -1)
+            return -1;
+        if (strm->avail_in >= BGZF_HEAD && strm->next_in[2] == 8 &&
+                strm->next_in[3] == 4 && strm->next_in[10] == 6 &&
+                strm->next_in[11] == 0 && strm->next_in[12] == 'B' &&
+                strm->next_in[13] == 'C' && strm->next_in[14] == 2 &&
+                strm->next_in[15] == 0) {
+            if (state->resume)
+                inflateReset(strm);
+            else {
+                inflateReset2(strm, -15);
+                state->resume = 1;
+            }
+            strm->next_in += BGZF_HEAD;
+            strm->avail_in -= BGZF_HEAD;
+            state->check = crc32(0L, Z_NULL, 0);
+        }
+        else if (state->resume) {
+            /* go back to gzip decoding after resuming at an access point */
+            inflateReset2(strm, 15 + 16);
+            state->resume = 0;
+        }
+        else
+            inflateReset(strm);
+        state->beg = state->x.pos;
         state->how = GZIP;
         state->direct = 0;
         return 0;
@@ -148,6 +436,169 @@ local int gz_look(gz_statep state) {
     return 0;
 }
 
+/* Add an access point at the current position in the gzip member, if it has
+   been at least span bytes since the last one.  produced is the number of
+   bytes decompressed so far in this gz_decomp() call.  This must only be
+   called when inflate() has just returned at a block boundary.  Return -1 on a
+   memory allocation failure, otherwise 0. */
+local int gz_mark(gz_statep state, unsigned produced) {
+    gz_point *point;
+    z_streamp strm = &(state->strm);
+    z_off64_t out = state->x.pos + produced;
+
+    /* see if we're far enough past the last access point for another */
+    if (out - (state->points ? state->list[state->points - 1].out : 0) <
+            state->span)
+        return 0;
+
+    /* make room for another access point */
+    if (state->points == state->room) {
+        int room = state->room ? state->room << 1 : 8;
+        if (room < 0 ||
+                (point = (gz_point *)realloc(state->list,
+                                             sizeof(gz_point) * room)) ==
+                NULL) {
+            gz_error(state, Z_MEM_ERROR, "out of memory");
+            return -1;
+        }
+        state->list = point;
+        state->room = room;
+    }
+
+    /* save the window, and where and how to resume decompressing */
+    point = state->list + state->points;
+    inflateGetDictionary(strm, Z_NULL, &point->dict);
+    point->window = NULL;
+    point->zlen = 0;
+    if (point->dict) {
+        point->window = (unsigned char *)malloc(point->dict);
+        if (point->window == NULL) {
+            gz_error(state, Z_MEM_ERROR, "out of memory");
+            return -1;
+        }
+        inflateGetDictionary(strm, point->window, &point->dict);
+    }
+    point->out = out;
+    point->in = state->raw - strm->avail_in;
+    point->bits = strm->data_type & 7;
+    point->beg = state->beg;
+    point->check = state->resume ? state->check : strm->adler;
+    state->points++;
+    return 0;
+}
+
+/* Resume decompression at the access point point.  The file is positioned at
+   the first compressed byte needed, and inflate is set up to decode raw
+   deflate data from there, with the window restored.  The gzip trailer at the
+   end of the member is checked by gz_trailer(), since inflate will not see it.
+   Return -1 on error, otherwise 0. */
+local int gz_jump(gz_statep state, gz_point *point) {
+    int ret;
+    unsigned char *window = point->window;
+    z_streamp strm = &(state->strm);
+
+    /* decompress the window if it was loaded from an index file */
+    if (point->zlen) {
+        window = (unsigned char *)malloc(point->dict);
+        if (window == NULL) {
+            gz_error(state, Z_MEM_ERROR, "out of memory");
+            return -1;
+        }
+        inflateReset2(strm, -15);
+        strm->next_in = point->window;
+        strm->avail_in = point->zlen;
+        strm->next_out = window;
+        strm->avail_out = point->dict;
+        ret = inflate(strm, Z_FINISH);
+        if (ret != Z_STREAM_END || strm->avail_out) {
+            free(window);
+            gz_error(state, ret == Z_MEM_ERROR ? Z_MEM_ERROR : Z_DATA_ERROR,
+                     "invalid index window");
+            return -1;
+        }
+    }
+
+    /* position the file, including the byte with the leading bits, if any */
+    state->raw = point->in - (point->bits ? 1 : 0);
+    state->eof = 0;
+    state->past = 0;
+    strm->avail_in = 0;
+    if (LSEEK(state->fd, state->raw, SEEK_SET) == -1) {
+        gz_error(state, Z_ERRNO, zstrerror());
+        ret = -1;
+    }
+    else
+        ret = gz_avail(state);
+    if (ret == 0 && point->bits && strm->avail_in == 0) {
+        gz_error(state, Z_BUF_ERROR, "unexpected end of file");
+        ret = -1;
+    }
+
+    /* prime inflate with the bits and the window preceding the point */
+    if (ret == 0) {
+        inflateReset2(strm, -15);
+        if (point->bits) {
+            inflatePrime(strm, point->bits,
+                         strm->next_in[0] >> (8 - point->bits));
+            strm->next_in++;
+            strm->avail_in--;
+        }
+        inflateSetDictionary(strm, window, point->dict);
+    }
+    if (window != point->window)
+        free(window);
+    if (ret == -1)
+        return -1;
+
+    /* continue decompressing the member from the point */
+    state->resume = 1;
+    state->check = point->check;
+    state->beg = point->beg;
+    state->how = GZIP;
+    state->direct = 0;
+    state->x.have = 0;
+    state->x.pos = point->out;
+    return 0;
+}
+
+/* Check the gzip trailer at the end of a member that was decompressed from an
+   access point or as a BGZF member.  end is the uncompressed offset of the end
+   of the member.  Inflate is left decoding raw deflate data, which gz_look()
+   will change if the next member isn't BGZF.  Return -1 on error, otherwise
+   0. */
+local int gz_trailer(gz_statep state, z_off64_t end) {
+    int n;
+    unsigned long check, len;
+    z_streamp strm = &(state->strm);
+
+    /* get the eight-byte trailer into the input buffer */
+    while (strm->avail_in < 8 && !state->eof)
+        if (gz_avail(state) == -1)
+            return -1;
+    if (strm->avail_in < 8) {
+        gz_error(state, Z_BUF_ERROR, "unexpected end of file");
+        return -1;
+    }
+
+    /* compare the check value and length with what was decompressed */
+    check = len = 0;
+    for (n = 3; n >= 0; n--) {
+        check = (check << 8) + strm->next_in[n];
+        len = (len << 8) + strm->next_in[n + 4];
+    }
+    strm->next_in += 8;
+    strm->avail_in -= 8;
+    if (check != state->check) {
+        gz_error(state, Z_DATA_ERROR, "incorrect data check");
+        return -1;
+    }
+    if (len != ((unsigned long)(end - state->beg) & 0xffffffffUL)) {
+        gz_error(state, Z_DATA_ERROR, "incorrect length check");
+        return -1;
+    }
+    return 0;
+}
+
 /* Decompress from input to the provided next_out and avail_out in the state.
    On return, state->x.have and state->x.next point to the just decompressed
    data.  If the gzip stream completes, state->how is reset to LOOK to look for
@@ -156,6 +607,7 @@ local int gz_look(gz_statep state) {
 local int gz_decomp(gz_statep state) {
     int ret = Z_OK;
     unsigned had;
+    unsigned char *put;
     z_streamp strm = &(state->strm);
 
     /* fill output buffer up to end of deflate stream */
@@ -169,8 +621,10 @@ local int gz_decomp(gz_statep state) {
             break;
         }
 
-        /* decompress and handle errors */
-        ret = inflate(strm, Z_NO_FLUSH);
+        /* decompress and handle errors -- stop at block boundaries if
+           making access points */
+        put = strm->next_out;
+        ret = inflate(strm, state->span ? Z_BLOCK : Z_NO_FLUSH);
         if (ret == Z_STREAM_ERROR || ret == Z_NEED_DICT) {
             gz_error(state, Z_STREAM_ERROR,
                      "internal error: inflate stream corrupt");
@@ -185,6 +639,15 @@ local int gz_decomp(gz_statep state) {
                      strm->msg == NULL ? "compressed data error" : strm->msg);
             return -1;
         }
+
+        /* update the check value when inflate can't, and note access points
+           at the ends of deflate blocks */
+        if (state->resume)
+            state->check = crc32(state->check, put,
+                                 (uInt)(strm->next_out - put));
+        if (state->span && (strm->data_type & 0xc0) == 0x80 &&
+                gz_mark(state, had - strm->avail_out) == -1)
+            return -1;
     } while (strm->avail_out && ret != Z_STREAM_END);
 
     /* update available output */
@@ -192,8 +655,12 @@ local int gz_decomp(gz_statep state) {
     state->x.next = strm->next_out - state->x.have;
 
     /* if the gzip stream completed successfully, look for another */
-    if (ret == Z_STREAM_END)
+    if (ret == Z_STREAM_END) {
+        if (state->resume &&
+                gz_trailer(state, state->x.pos + state->x.have) == -1)
+            return -1;
         state->how = LOOK;
+    }
 
     /* good decompression */
     return 0;
@@ -232,9 +699,35 @@ local int gz_fetch(gz_statep state) {
     return 0;
 }
 
-/* Skip len uncompressed bytes of output.  Return -1 on error, 0 on success. */
+/* Skip len uncompressed bytes of output.  If there is an access point ahead
+   of the data decompressed so far, and at or before the destination, then jump
+   to the last such point instead of decompressing up to it.  Return -1 on
+   error, 0 on success. */
 local int gz_skip(gz_statep state, z_off64_t len) {
     unsigned n;
+    z_off64_t to = state->x.pos + len;
+
+    /* if nothing has been read yet, set up for reading first, which loads a
+       sidecar index if requested */
+    if (state->size == 0 && gz_look(state) == -1)
+        return -1;
+
+    /* find the last access point at or before the destination */
+    if (state->points) {
+        int lo = -1, hi = state->points, mid;
+        while (hi - lo > 1) {
+            mid = (lo + hi) >> 1;
+            if (to < state->list[mid].out)
+                hi = mid;
+            else
+                lo = mid;
+        }
+        if (lo >= 0 && state->list[lo].out > state->x.pos + state->x.have) {
+            if (gz_jump(state, state->list + lo) == -1)
+                return -1;
+            len = to - state->x.pos;
+        }
+    }
 
     /* skip over len bytes or reach end-of-file, whichever comes first */
     while (len)
@@ -556,6 +1049,376 @@ char * ZEXPORT gzgets(gzFile file, char *buf, int len) {
     return str;
 }
 
+/* Append n bytes at the next output to the line being built in state->line,
+   of which there are used bytes so far.  Return -1 if out of memory, else 0.
+   The output is consumed. */
+local int gz_stitch(gz_statep state, z_size_t used, unsigned n) {
+    z_size_t size;
+    unsigned char *line;
+
+    if (state->lsize - used < n) {
+        size = state->lsize ? state->lsize << 1 : GZBUFSIZE;
+        while (size - used < n && size > state->lsize)
+            size <<= 1;
+        if (size - used < n || size <= state->lsize ||
+            (line = (unsigned char *)realloc(state->line, size)) == NULL) {
+            gz_error(state, Z_MEM_ERROR, "out of memory");
+            return -1;
+        }
+        state->line = line;
+        state->lsize = size;
+    }
+    memcpy(state->line + used, state->x.next, n);
+    state->x.have -= n;
+    state->x.next += n;
+    state->x.pos += n;
+    return 0;
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzgetline(gzFile file, const char **line, z_size_t *len) {
+    unsigned n;
+    z_size_t used;
+    unsigned char *eol;
+    gz_statep state;
+
+    /* check parameters and get internal structure */
+    if (file == NULL || line == NULL || len == NULL)
+        return -1;
+    state = (gz_statep)file;
+
+    /* check that we're reading and that there's no (serious) error */
+    if (state->mode != GZ_READ ||
+        (state->err != Z_OK && state->err != Z_BUF_ERROR))
+        return -1;
+
+    /* process a skip request */
+    if (state->seek) {
+        state->seek = 0;
+        if (gz_skip(state, state->skip) == -1)
+            return -1;
+    }
+
+    /* assure that something is in the output buffer */
+    if (state->x.have == 0 && gz_fetch(state) == -1)
+        return -1;
+
+    /* if the whole line is in the output buffer, return it in place */
+    eol = state->x.have == 0 ? NULL :
+          (unsigned char *)memchr(state->x.next, '\n', state->x.have);
+    if (eol != NULL) {
+        n = (unsigned)(eol - state->x.next) + 1;
+        *line = (const char *)state->x.next;
+        *len = n;
+        state->x.have -= n;
+        state->x.next += n;
+        state->x.pos += n;
+        return 1;
+    }
+
+    /* otherwise assemble the line from successive output buffers */
+    used = 0;
+    for (;;) {
+        if (state->x.have == 0 && gz_fetch(state) == -1)
+            return -1;                  /* error */
+        if (state->x.have == 0) {       /* end of file */
+            state->past = 1;            /* read past end */
+            break;                      /* return what we have */
+        }
+        n = state->x.have;
+        eol = (unsigned char *)memchr(state->x.next, '\n', n);
+        if (eol != NULL)
+            n = (unsigned)(eol - state->x.next) + 1;
+        if (gz_stitch(state, used, n) == -1)
+            return -1;
+        used += n;
+        if (eol != NULL)
+            break;
+    }
+
+    /* return the line, or if nothing, end of file */
+    if (used == 0)
+        return 0;
+    *line = (const char *)state->line;
+    *len = used;
+    return 1;
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzgetlines(gzFile file, const char **lines, z_size_t *lens,
+                       int max) {
+    int got;
+    unsigned n;
+    unsigned char *eol;
+    gz_statep state;
+
+    /* get the first line, reading more input if needed */
+    if (lines == NULL || lens == NULL || max < 1)
+        return -1;
+    got = gzgetline(file, lines, lens);
+    if (got != 1)
+        return got;
+
+    /* add the complete lines left in the output buffer */
+    state = (gz_statep)file;
+    while (got < max && state->x.have &&
+           (eol = (unsigned char *)memchr(state->x.next, '\n',
+                                          state->x.have)) != NULL) {
+        n = (unsigned)(eol - state->x.next) + 1;
+        lines[got] = (const char *)state->x.next;
+        lens[got++] = n;
+        state->x.have -= n;
+        state->x.next += n;
+        state->x.pos += n;
+    }
+    return got;
+}
+
+#ifndef NO_PREAD
+
+/* Make sure that there are at least need bytes of input in strm, if there are
+   that many left in the file, reading from the file at offset *pos into the
+   size bytes at in.  Return -1 on a read error, otherwise 0. */
+local int gz_pget(int fd, unsigned char *in, unsigned size, z_streamp strm,
+                  z_off64_t *pos, unsigned need) {
+    ssize_t got;
+
+    while (strm->avail_in < need) {
+        if (strm->avail_in)
+            memmove(in, strm->next_in, strm->avail_in);
+        strm->next_in = in;
+        got = PREAD(fd, in + strm->avail_in, size - strm->avail_in, *pos);
+        if (got < 0)
+            return -1;
+        if (got == 0)
+            break;
+        strm->avail_in += (unsigned)got;
+        *pos += got;
+    }
+    return 0;
+}
+
+/* Read len bytes at offset in the uncompressed data of state into buf, using
+   only local decompression state and pread(), so that this can be used by
+   several threads at once.  Return the number of bytes read, or a negative
+   zlib error code. */
+local int gz_pread(gz_statep state, unsigned char *buf, unsigned len,
+                   z_off64_t offset) {
+    int ret, lo, hi, mid, raw;
+    unsigned size = state->want, got = 0, n;
+    unsigned char *in, *win, *window;
+    z_off64_t pos, skip;
+    z_stream strm;
+    gz_point *point = NULL;
+
+    /* allocate the input buffer, window, and inflate state */
+    in = (unsigned char *)malloc(size);
+    win = (unsigned char *)malloc(32768U);
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.next_in = in;
+    strm.avail_in = 0;
+    if (in == NULL || win == NULL || inflateInit2(&strm, -15) != Z_OK) {
+        free(win);
+        free(in);
+        return Z_MEM_ERROR;
+    }
+
+    /* find the last access point at or before offset */
+    lo = -1;
+    hi = state->points;
+    while (hi - lo > 1) {
+        mid = (lo + hi) >> 1;
+        if (offset < state->list[mid].out)
+            hi = mid;
+        else
+            lo = mid;
+    }
+    if (lo >= 0)
+        point = state->list + lo;
+
+    /* set up to decompress from the access point, or from the start */
+    ret = Z_OK;
+    if (point != NULL) {
+        window = point->window;
+        if (point->zlen) {
+            strm.next_in = point->window;
+            strm.avail_in = point->zlen;
+            strm.next_out = win;
+            strm.avail_out = point->dict;
+            ret = inflate(&strm, Z_FINISH);
+            ret = ret == Z_STREAM_END && strm.avail_out == 0 ? Z_OK :
+                  ret == Z_MEM_ERROR ? ret : Z_DATA_ERROR;
+            window = win;
+            strm.next_in = in;
+            strm.avail_in = 0;
+            inflateReset(&strm);
+        }
+        pos = point->in - (point->bits ? 1 : 0);
+        if (ret == Z_OK && point->bits) {
+            if (gz_pget(state->fd, in, size, &strm, &pos, 1) == -1)
+                ret = Z_ERRNO;
+            else if (strm.avail_in == 0)
+                ret = Z_BUF_ERROR;
+            else {
+                inflatePrime(&strm, point->bits,
+                             strm.next_in[0] >> (8 - point->bits));
+                strm.next_in++;
+                strm.avail_in--;
+            }
+        }
+        if (ret == Z_OK)
+            inflateSetDictionary(&strm, window, point->dict);
+        raw = 1;
+        skip = offset - point->out;
+    }
+    else {
+        pos = state->start;
+        if (gz_pget(state->fd, in, size, &strm, &pos, 2) == -1)
+            ret = Z_ERRNO;
+        else if (strm.avail_in < 2 ||
+                 strm.next_in[0] != 31 || strm.next_in[1] != 139) {
+            /* not a gzip file -- read it directly */
+            pos = state->start + offset;
+            while (got < len) {
+                ssize_t red = PREAD(state->fd, buf + got, len - got, pos);
+                if (red <= 0) {
+                    if (red < 0)
+                        ret = Z_ERRNO;
+                    break;
+                }
+                got += (unsigned)red;
+                pos += red;
+            }
+            len = got;
+        }
+        else
+            inflateReset2(&strm, 15 + 16);
+        raw = 0;
+        skip = offset;
+    }
+
+    /* decompress, discarding skip bytes, and then filling buf */
+    while (ret == Z_OK && got < len) {
+        if (gz_pget(state->fd, in, size, &strm, &pos, 1) == -1) {
+            ret = Z_ERRNO;
+            break;
+        }
+        if (strm.avail_in == 0) {
+            ret = Z_BUF_ERROR;
+            break;
+        }
+        if (skip) {
+            strm.next_out = win;
+            strm.avail_out = skip < 32768 ? (unsigned)skip : 32768U;
+        }
+        else {
+            strm.next_out = buf + got;
+            strm.avail_out = len - got;
+        }
+        n = strm.avail_out;
+        ret = inflate(&strm, Z_NO_FLUSH);
+        n -= strm.avail_out;
+        if (skip)
+            skip -= n;
+        else
+            got += n;
+        if (ret == Z_NEED_DICT)
+            ret = Z_DATA_ERROR;
+        if (ret != Z_STREAM_END)
+            continue;
+
+        /* end of a member -- skip the trailer if decoding raw, and continue
+           with the next member if there is one */
+        ret = Z_OK;
+        if (gz_pget(state->fd, in, size, &strm, &pos, raw ? 10 : 2) == -1) {
+            ret = Z_ERRNO;
+            break;
+        }
+        if (raw) {
+            if (strm.avail_in < 8) {
+                ret = Z_BUF_ERROR;
+                break;
+            }
+            strm.next_in += 8;
+            strm.avail_in -= 8;
+            raw = 0;
+            inflateReset2(&strm, 15 + 16);
+        }
+        else
+            inflateReset(&strm);
+        if (strm.avail_in < 2 ||
+                strm.next_in[0] != 31 || strm.next_in[1] != 139)
+            break;                  /* end of gzip members */
+    }
+
+    /* free the local state and return the amount read, or the error */
+    inflateEnd(&strm);
+    free(win);
+    free(in);
+    return ret == Z_OK ? (int)got : ret;
+}
+
+#endif
+
+/* -- see zlib.h -- */
+int ZEXPORT gzpread(gzFile file, voidp buf, unsigned len, z_off64_t offset) {
+    gz_statep state;
+
+    /* get internal structure */
+    if (file == NULL || buf == NULL || offset < 0)
+        return Z_STREAM_ERROR;
+    state = (gz_statep)file;
+
+    /* check that we're reading, and that the length fits in an int */
+    if (state->mode != GZ_READ || (int)len < 0)
+        return Z_STREAM_ERROR;
+    if (len == 0)
+        return 0;
+
+    /* read from offset */
+#ifdef NO_PREAD
+    return Z_STREAM_ERROR;
+#else
+    return gz_pread(state, (unsigned char *)buf, len, offset);
+#endif
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzsaveindex(gzFile file, const char *path) {
+    gz_statep state;
+
+    /* get internal structure */
+    if (file == NULL || path == NULL)
+        return Z_STREAM_ERROR;
+    state = (gz_statep)file;
+
+    /* check that we're reading */
+    if (state->mode != GZ_READ)
+        return Z_STREAM_ERROR;
+
+    /* save the index */
+    return gz_write_index(state, path);
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzloadindex(gzFile file, const char *path) {
+    gz_statep state;
+
+    /* get internal structure */
+    if (file == NULL || path == NULL)
+        return Z_STREAM_ERROR;
+    state = (gz_statep)file;
+
+    /* check that we're reading */
+    if (state->mode != GZ_READ)
+        return Z_STREAM_ERROR;
+
+    /* load the index */
+    return gz_read_index(state, path);
+}
+
 /* -- see zlib.h -- */
 int ZEXPORT gzdirect(gzFile file) {
     gz_statep state;
@@ -594,6 +1457,8 @@ int ZEXPORT gzclose_r(gzFile file) {
         free(state->out);
         free(state->in);
     }
+    free(state->line);
+    gz_unindex(state);
     err = state->err == Z_BUF_ERROR ? Z_BUF_ERROR : Z_OK;
     gz_error(state, Z_OK, NULL);
     free(state->path);
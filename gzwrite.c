@@ -12,6 +12,10 @@ local int gz_init(gz_statep state) {
     int ret;
     z_streamp strm = &(state->strm);
 
+    /* BGZF members are made from one input buffer of data each */
+    if (state->bgzf && !state->direct)
+        state->want = BGZF_BLOCK;
+
     /* allocate input buffer (double size for gzprintf) */
     state->in = (unsigned char *)malloc(state->want << 1);
     if (state->in == NULL) {
@@ -22,19 +26,22 @@ local int gz_init(gz_statep state) {
     /* only need output buffer and deflate state if compressing */
     if (!state->direct) {
         /* allocate output buffer */
-        state->out = (unsigned char *)malloc(state->want);
+        state->out = (unsigned char *)malloc(state->bgzf ? BGZF_MAX :
+                                                           state->want);
         if (state->out == NULL) {
             free(state->in);
             gz_error(state, Z_MEM_ERROR, "out of memory");
             return -1;
         }
 
-        /* allocate deflate memory, set up for gzip compression */
+        /* allocate deflate memory, set up for gzip compression, or raw
+           deflate for BGZF */
         strm->zalloc = Z_NULL;
         strm->zfree = Z_NULL;
         strm->opaque = Z_NULL;
         ret = deflateInit2(strm, state->level, Z_DEFLATED,
-                           MAX_WBITS + 16, DEF_MEM_LEVEL, state->strategy);
+                           state->bgzf ? -MAX_WBITS : MAX_WBITS + 16,
+                           DEF_MEM_LEVEL, state->strategy);
         if (ret != Z_OK) {
             free(state->out);
             free(state->in);
@@ -56,44 +63,177 @@ local int gz_init(gz_statep state) {
     return 0;
 }
 
-/* Compress whatever is at avail_in and next_in and write to the output file.
-   Return -1 if there is an error writing to the output file or if gz_init()
-   fails to allocate memory, otherwise 0.  flush is assumed to be a valid
-   deflate() flush value.  If flush is Z_FINISH, then the deflate() state is
-   reset to start a new gzip stream.  If gz->direct is true, then simply write
-   to the output file without compressing, and ignore flush. */
-local int gz_comp(gz_statep state, int flush) {
-    int ret, writ;
-    unsigned have, put, max = ((unsigned)-1 >> 2) + 1;
+/* Put val in n bytes at buf in little-endian order. */
+local void gz_le(unsigned char *buf, z_off64_t val, int n) {
+    while (n--) {
+        *buf++ = (unsigned char)val;
+        val >>= 8;
+    }
+}
+
+/* Write len bytes from buf to fd.  Return -1 on error, otherwise 0. */
+local int gz_out(int fd, const unsigned char *buf, unsigned len) {
+    int writ;
+
+    while (len) {
+        writ = write(fd, buf, len > 65536U ? 65536U : len);
+        if (writ <= 0)
+            return -1;
+        buf += writ;
+        len -= (unsigned)writ;
+    }
+    return 0;
+}
+
+/* Add an access point to the index being built while writing, at the current
+   position in the uncompressed data.  Either deflate() has just completed a
+   block with Z_BLOCK and all of its output has been taken, or for BGZF this is
+   the start of the next member, which needs no window.  Return -1 on a memory
+   allocation failure, otherwise 0. */
+local int gz_mark(gz_statep state) {
+    int bits;
+    unsigned pending;
+    gz_point *point;
     z_streamp strm = &(state->strm);
 
-    /* allocate memory if this is the first time through */
-    if (state->size == 0 && gz_init(state) == -1)
-        return -1;
+    /* make room for another access point */
+    if (state->points == state->room) {
+        int room = state->room ? state->room << 1 : 8;
+        if (room < 0 ||
+                (point = (gz_point *)realloc(state->list,
+                                             sizeof(gz_point) * room)) ==
+                NULL) {
+            gz_error(state, Z_MEM_ERROR, "out of memory");
+            return -1;
+        }
+        state->list = point;
+        state->room = room;
+    }
 
-    /* write directly if requested */
-    if (state->direct) {
-        while (strm->avail_in) {
-            put = strm->avail_in > max ? max : strm->avail_in;
-            writ = write(state->fd, strm->next_in, put);
-            if (writ < 0) {
-                gz_error(state, Z_ERRNO, zstrerror());
+    /* save where the next block starts in the file, and the window */
+    point = state->list + state->points;
+    point->out = state->x.pos - strm->avail_in;
+    point->window = NULL;
+    point->zlen = 0;
+    point->dict = 0;
+    if (state->bgzf) {
+        point->in = state->block + BGZF_HEAD;
+        point->bits = 0;
+        point->beg = point->out;
+        point->check = crc32(0L, Z_NULL, 0);
+    }
+    else {
+        deflatePending(strm, &pending, &bits);
+        point->in = state->block + (z_off64_t)strm->total_out + pending +
+                    (bits ? 1 : 0);
+        point->bits = bits ? 8 - bits : 0;
+        point->beg = state->beg;
+        point->check = strm->adler;
+        deflateGetDictionary(strm, Z_NULL, &point->dict);
+        if (point->dict) {
+            point->window = (unsigned char *)malloc(point->dict);
+            if (point->window == NULL) {
+                gz_error(state, Z_MEM_ERROR, "out of memory");
                 return -1;
             }
-            strm->avail_in -= (unsigned)writ;
-            strm->next_in += writ;
+            deflateGetDictionary(strm, point->window, &point->dict);
         }
-        return 0;
     }
+    state->points++;
+    return 0;
+}
 
-    /* check for a pending reset */
-    if (state->reset) {
-        /* don't start a new gzip member unless there is data to write */
-        if (strm->avail_in == 0)
-            return 0;
+/* Compress the pending input as BGZF members of at most BGZF_BLOCK bytes of
+   data each, and write them to the output file.  Each member is compressed
+   from scratch using raw deflate, with the header and trailer made here.
+   Return -1 on a write error, otherwise 0. */
+local int gz_bgzf(gz_statep state) {
+    int ret;
+    unsigned len, left, size;
+    unsigned long check;
+    unsigned char *out = state->out;
+    z_streamp strm = &(state->strm);
+
+    while (strm->avail_in) {
+        /* add an access point at the start of the member if due */
+        if (state->span && state->x.pos - strm->avail_in -
+                (state->points ? state->list[state->points - 1].out : 0) >=
+                state->span && gz_mark(state) == -1)
+            return -1;
+
+        /* compress the next member's worth of data */
+        len = strm->avail_in > BGZF_BLOCK ? BGZF_BLOCK : strm->avail_in;
+        left = strm->avail_in - len;
+        check = crc32(0L, strm->next_in, len);
+        strm->avail_in = len;
+        strm->next_out = out + BGZF_HEAD;
+        strm->avail_out = BGZF_MAX - BGZF_HEAD - 8;
+        ret = deflate(strm, Z_FINISH);
+        if (ret == Z_STREAM_ERROR) {
+            gz_error(state, Z_STREAM_ERROR,
+                      "internal error: deflate stream corrupt");
+            return -1;
+        }
+        if (ret == Z_STREAM_END)
+            size = (unsigned)(strm->next_out - out);
+        else {
+            /* didn't fit -- use a stored block instead, which always fits */
+            strm->next_in -= len - strm->avail_in;
+            out[BGZF_HEAD] = 1;
+            gz_le(out + BGZF_HEAD + 1, len, 2);
+            gz_le(out + BGZF_HEAD + 3, ~len, 2);
+            memcpy(out + BGZF_HEAD + 5, strm->next_in, len);
+            strm->next_in += len;
+            size = BGZF_HEAD + 5 + len;
+        }
+        strm->avail_in = left;
         deflateReset(strm);
-        state->reset = 0;
+
+        /* add the header with the member size, and the trailer, and write */
+        memcpy(out, "\037\213\010\004\0\0\0\0\0\377\006\0BC\002\0", 16);
+        gz_le(out + 16, size + 8 - 1, 2);
+        gz_le(out + size, (z_off64_t)check, 4);
+        gz_le(out + size + 4, len, 4);
+        size += 8;
+        if (gz_out(state->fd, out, size) == -1) {
+            gz_error(state, Z_ERRNO, zstrerror());
+            return -1;
+        }
+        state->block += size;
     }
+    return 0;
+}
+
+/* Update the rolling hash for up to len bytes of input at next_in, stopping
+   after the first byte where an rsync flush is due.  Return the number of
+   bytes through that byte, or 0 if no flush is due in the len bytes, in which
+   case all len bytes were hashed. */
+local unsigned gz_rsync(gz_statep state, unsigned len) {
+    unsigned n = 0, hash = state->rhash;
+    z_const unsigned char *next = state->strm.next_in;
+
+    while (n < len) {
+        hash = ((hash << 1) ^ next[n++]) & RSYNC_MASK;
+        if (state->rgap < RSYNC_MIN)
+            state->rgap++;
+        else if (hash == RSYNC_HIT) {
+            state->rhash = hash;
+            state->rgap = 0;
+            return n;
+        }
+    }
+    state->rhash = hash;
+    return 0;
+}
+
+/* Run deflate() with flush on the input at avail_in and next_in until it
+   produces no more output, writing the output to the file.  Output is written
+   when the buffer is full, or when flushing, but if doing Z_FINISH then not
+   until the end of the stream.  Return -1 on an error, otherwise 0. */
+local int gz_deflate(gz_statep state, int flush) {
+    int ret, writ;
+    unsigned have, put, max = ((unsigned)-1 >> 2) + 1;
+    z_streamp strm = &(state->strm);
 
     /* run deflate() on provided input until it produces no more output */
     ret = Z_OK;
@@ -130,6 +270,91 @@ local int gz_comp(gz_statep state, int flush) {
         have -= strm->avail_out;
     } while (have);
 
+    return 0;
+}
+
+/* Compress whatever is at avail_in and next_in and write to the output file.
+   Return -1 if there is an error writing to the output file or if gz_init()
+   fails to allocate memory, otherwise 0.  flush is assumed to be a valid
+   deflate() flush value.  If flush is Z_FINISH, then the deflate() state is
+   reset to start a new gzip stream.  If gz->direct is true, then simply write
+   to the output file without compressing, and ignore flush. */
+local int gz_comp(gz_statep state, int flush) {
+    int writ;
+    unsigned put, max = ((unsigned)-1 >> 2) + 1;
+    z_streamp strm = &(state->strm);
+
+    /* allocate memory if this is the first time through */
+    if (state->size == 0 && gz_init(state) == -1)
+        return -1;
+
+    /* write directly if requested */
+    if (state->direct) {
+        while (strm->avail_in) {
+            put = strm->avail_in > max ? max : strm->avail_in;
+            writ = write(state->fd, strm->next_in, put);
+            if (writ < 0) {
+                gz_error(state, Z_ERRNO, zstrerror());
+                return -1;
+            }
+            strm->avail_in -= (unsigned)writ;
+            strm->next_in += writ;
+        }
+        return 0;
+    }
+
+    /* make BGZF members from all of the input, regardless of flush */
+    if (state->bgzf)
+        return gz_bgzf(state);
+
+    /* check for a pending reset, noting where the new member starts */
+    if (state->reset) {
+        /* don't start a new gzip member unless there is data to write */
+        if (strm->avail_in == 0)
+            return 0;
+        state->block += (z_off64_t)strm->total_out;
+        state->beg = state->x.pos - strm->avail_in;
+        deflateReset(strm);
+        state->reset = 0;
+    }
+
+    /* if building an index, end a deflate block after each span of data and
+       add an access point there, and if rsyncable, do a full flush after
+       each content-defined point in the data */
+    while ((state->span || state->rsync) && strm->avail_in) {
+        int cut = Z_NO_FLUSH, mark = 0;
+        unsigned len = strm->avail_in, left, n;
+        if (state->span) {
+            z_off64_t to = (state->points ?
+                            state->list[state->points - 1].out : 0) +
+                           state->span - (state->x.pos - strm->avail_in);
+            if (to <= (z_off64_t)len) {
+                len = to < 0 ? 0 : (unsigned)to;
+                cut = Z_BLOCK;
+                mark = 1;
+            }
+        }
+        if (state->rsync && (n = gz_rsync(state, len)) != 0) {
+            if (n < len)
+                mark = 0;
+            len = n;
+            cut = Z_FULL_FLUSH;
+        }
+        if (cut == Z_NO_FLUSH)
+            break;
+        left = strm->avail_in - len;
+        strm->avail_in = len;
+        if (gz_deflate(state, cut) == -1)
+            return -1;
+        strm->avail_in = left;
+        if (mark && gz_mark(state) == -1)
+            return -1;
+    }
+
+    /* compress what's left */
+    if (gz_deflate(state, flush) == -1)
+        return -1;
+
     /* if that completed a deflate stream, allow another to start */
     if (flush == Z_FINISH)
         state->reset = 1;
@@ -188,8 +413,9 @@ local z_size_t gz_write(gz_statep state, voidpc buf, z_size_t len) {
             return 0;
     }
 
-    /* for small len, copy to input buffer, otherwise compress directly */
-    if (len < state->size) {
+    /* for small len, or always when making BGZF members, copy to input buffer,
+       otherwise compress directly */
+    if (len < state->size || state->bgzf) {
         /* copy to input buffer, compress when full */
         do {
             unsigned have, copy;
@@ -612,9 +838,24 @@ int ZEXPORT gzclose_w(gzFile file) {
             ret = state->err;
     }
 
-    /* flush, free memory, and close file */
+    /* flush, free memory, and close file -- BGZF ends with an empty member */
     if (gz_comp(state, Z_FINISH) == -1)
         ret = state->err;
+    else if (state->bgzf && !state->direct &&
+             gz_out(state->fd, (const unsigned char *)
+                    "\037\213\010\004\0\0\0\0\0\377\006\0BC\002\0\033\0"
+                    "\003\0\0\0\0\0\0\0\0\0", 28) == -1) {
+        gz_error(state, Z_ERRNO, zstrerror());
+        ret = state->err;
+    }
+
+    /* save the index built while writing next to the file, if requested */
+    if (ret == Z_OK && state->sidecar && (state->span || state->points)) {
+        char *path = gz_sidecar(state);
+        ret = path == NULL ? Z_MEM_ERROR : gz_write_index(state, path);
+        free(path);
+    }
+    gz_unindex(state);
     if (state->size) {
         if (!state->direct) {
             (void)deflateEnd(&(state->strm));
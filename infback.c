@@ -34,6 +34,15 @@ int ZEXPORT inflateBackInit_(z_streamp strm, int windowBits,
         windowBits < 8 || windowBits > 15)
         return Z_STREAM_ERROR;
     strm->msg = Z_NULL;                 /* in case we return an error */
+    if (strm->zalloc == Z_POOL_ALLOC) {
+#ifdef Z_SOLO
+        return Z_STREAM_ERROR;
+#else
+        strm->zalloc = zpalloc;
+        strm->zfree = zpfree;
+        strm->opaque = (voidpf)0;
+#endif
+    }
     if (strm->zalloc == (alloc_func)0) {
 #ifdef Z_SOLO
         return Z_STREAM_ERROR;
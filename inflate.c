@@ -185,6 +185,15 @@ int ZEXPORT inflateInit2_(z_streamp strm, int windowBits,
         return Z_VERSION_ERROR;
     if (strm == Z_NULL) return Z_STREAM_ERROR;
     strm->msg = Z_NULL;                 /* in case we return an error */
+    if (strm->zalloc == Z_POOL_ALLOC) {
+#ifdef Z_SOLO
+        return Z_STREAM_ERROR;
+#else
+        strm->zalloc = zpalloc;
+        strm->zfree = zpfree;
+        strm->opaque = (voidpf)0;
+#endif
+    }
     if (strm->zalloc == (alloc_func)0) {
 #ifdef Z_SOLO
         return Z_STREAM_ERROR;
@@ -220,6 +229,34 @@ int ZEXPORT inflateInit_(z_streamp strm, const char *version,
     return inflateInit2_(strm, DEF_WBITS, version, stream_size);
 }
 
+z_size_t ZEXPORT inflateWorkspaceSize(int windowBits) {
+    if (windowBits < 0)
+        windowBits = windowBits < -15 ? 0 : -windowBits;
+    else if (windowBits < 48)
+        windowBits &= 15;
+    if (windowBits == 0)
+        windowBits = 15;
+    if (windowBits < 8 || windowBits > 15)
+        return 0;
+    return ZWORK_BASE + ZWORK_ROUND(sizeof(struct inflate_state)) +
+           ZWORK_ROUND((z_size_t)1 << windowBits);
+}
+
+int ZEXPORT inflateInitWorkspace_(z_streamp strm, int windowBits,
+                                  voidp work, z_size_t size,
+                                  const char *version, int stream_size) {
+    z_size_t need;
+
+    if (strm == Z_NULL) return Z_STREAM_ERROR;
+    need = inflateWorkspaceSize(windowBits);
+    if (need != 0 && size < need) return Z_MEM_ERROR;
+    strm->opaque = zwinit(work, size);
+    if (strm->opaque == Z_NULL) return Z_MEM_ERROR;
+    strm->zalloc = zwalloc;
+    strm->zfree = zwfree;
+    return inflateInit2_(strm, windowBits, version, stream_size);
+}
+
 int ZEXPORT inflatePrime(z_streamp strm, int bits, int value) {
     struct inflate_state FAR *state;
 
@@ -1327,6 +1364,29 @@ int ZEXPORT inflateSetDictionary(z_streamp strm, const Bytef *dictionary,
     return Z_OK;
 }
 
+int ZEXPORT inflateUseDictionary(z_streamp strm, z_dictp dict) {
+    struct inflate_state FAR *state;
+
+    /* check state */
+    if (inflateStateCheck(strm) || dict == Z_NULL) return Z_STREAM_ERROR;
+    state = (struct inflate_state FAR *)strm->state;
+    if (state->wrap != 0 && state->mode != DICT)
+        return Z_STREAM_ERROR;
+
+    /* check the precomputed dictionary identifier */
+    if (state->mode == DICT && dict->id != state->check)
+        return Z_DATA_ERROR;
+
+    /* copy the tail of the dictionary to the window */
+    if (updatewindow(strm, dict->window + dict->len, dict->len)) {
+        state->mode = MEM;
+        return Z_MEM_ERROR;
+    }
+    state->havedict = 1;
+    Tracev((stderr, "inflate:   dictionary set\n"));
+    return Z_OK;
+}
+
 int ZEXPORT inflateGetHeader(z_streamp strm, gz_headerp head) {
     struct inflate_state FAR *state;
 
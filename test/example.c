@@ -164,6 +164,452 @@ static void test_gzio(const char *fname, Byte *uncompr, uLong uncomprLen) {
 #endif
 }
 
+/* ===========================================================================
+ * Fill buf with len bytes of compressible but not trivially repetitive text
+ */
+static void make_text(Byte *buf, uLong len) {
+    static const char *words[] = {
+        "hello", "world", "zlib", "deflate", "inflate", "gzip", "window",
+        "block", "stream", "index", "seek", "point", "data", "\n"
+    };
+    unsigned long rand = 1;
+    uLong i = 0;
+    const char *w;
+
+    while (i < len) {
+        rand = rand * 1103515245UL + 12345;
+        w = words[(rand >> 16) % (sizeof(words) / sizeof(words[0]))];
+        while (*w && i < len)
+            buf[i++] = (Byte)*w++;
+        if (i < len)
+            buf[i++] = ' ';
+    }
+}
+
+/* ===========================================================================
+ * Test gzseek() with access points recorded by gzindex()
+ */
+static void test_gzindex(const char *fname) {
+#ifdef NO_GZCOMPRESS
+    fprintf(stderr, "NO_GZCOMPRESS -- gz* functions cannot compress\n");
+#else
+    int err, i;
+    uLong len = 1000000L;
+    Byte *data, *got;
+    char sidecar[1024];
+    gzFile file;
+    z_off_t pos;
+    static const z_off_t seeks[] = {
+        900000L, 100L, 500000L, 499999L, 700000L, 0L, 999990L, 350000L
+    };
+
+    data = (Byte*)malloc(len);
+    got = (Byte*)malloc(100);
+    if (data == Z_NULL || got == Z_NULL ||
+        strlen(fname) + 5 > sizeof(sidecar)) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    make_text(data, len);
+
+    /* write two gzip members */
+    file = gzopen(fname, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    if (gzwrite(file, data, 400000) != 400000 ||
+        gzflush(file, Z_FINISH) != Z_OK ||
+        gzwrite(file, data + 400000, (unsigned)len - 400000) !=
+            (int)len - 400000) {
+        fprintf(stderr, "gzwrite err: %s\n", gzerror(file, &err));
+        exit(1);
+    }
+    gzclose(file);
+
+    /* read it all while building an index */
+    file = gzopen(fname, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    if (gzindex(file, 65536L) != 0) {
+        fprintf(stderr, "gzindex error\n");
+        exit(1);
+    }
+    for (pos = 0; pos < (z_off_t)len; pos += 100)
+        if (gzread(file, got, 100) != 100 || memcmp(got, data + pos, 100)) {
+            fprintf(stderr, "gzread err at %ld: %s\n", (long)pos,
+                    gzerror(file, &err));
+            exit(1);
+        }
+
+    /* seek around using the access points */
+    for (i = 0; i < (int)(sizeof(seeks) / sizeof(seeks[0])); i++) {
+        pos = gzseek(file, seeks[i], SEEK_SET);
+        if (pos != seeks[i] ||
+            gzread(file, got, 10) != 10 || memcmp(got, data + pos, 10)) {
+            fprintf(stderr, "gzseek error at %ld: %s\n", (long)seeks[i],
+                    gzerror(file, &err));
+            exit(1);
+        }
+    }
+
+    /* read through the member boundary and trailer after resuming */
+    gzseek(file, 300000L, SEEK_SET);
+    for (pos = 300000L; pos < (z_off_t)len; pos += 100)
+        if (gzread(file, got, 100) != 100 || memcmp(got, data + pos, 100)) {
+            fprintf(stderr, "gzread after gzseek err at %ld: %s\n",
+                    (long)pos, gzerror(file, &err));
+            exit(1);
+        }
+    if (gzread(file, got, 1) != 0) {
+        fprintf(stderr, "gzread at end error\n");
+        exit(1);
+    }
+    printf("gzseek() with gzindex(): OK\n");
+
+    /* save the index next to the file, and use it on a new gzopen() */
+    strcpy(sidecar, fname);
+    strcat(sidecar, ".zri");
+    err = gzsaveindex(file, sidecar);
+    CHECK_ERR(err, "gzsaveindex");
+    if (gzclose(file) != Z_OK) {
+        fprintf(stderr, "gzclose error\n");
+        exit(1);
+    }
+    file = gzopen(fname, "rbi");
+    if (file == NULL) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    for (i = 0; i < (int)(sizeof(seeks) / sizeof(seeks[0])); i++) {
+        pos = gzseek(file, seeks[i], SEEK_SET);
+        if (pos != seeks[i] ||
+            gzread(file, got, 10) != 10 || memcmp(got, data + pos, 10)) {
+            fprintf(stderr, "gzseek with saved index error at %ld: %s\n",
+                    (long)seeks[i], gzerror(file, &err));
+            exit(1);
+        }
+    }
+    if (gzpread(file, got, 1, 0) == Z_STREAM_ERROR)
+        fprintf(stderr, "no pread() -- gzpread() is not available\n");
+    else
+        for (i = 0; i < (int)(sizeof(seeks) / sizeof(seeks[0])); i++) {
+            int want = seeks[i] + 100 > (z_off_t)len ?
+                       (int)(len - seeks[i]) : 100;
+            if (gzpread(file, got, 100, seeks[i]) != want ||
+                memcmp(got, data + seeks[i], want)) {
+                fprintf(stderr, "gzpread error at %ld\n", (long)seeks[i]);
+                exit(1);
+            }
+        }
+    err = gzloadindex(file, sidecar);
+    CHECK_ERR(err, "gzloadindex");
+    if (gzloadindex(file, fname) != Z_DATA_ERROR) {
+        fprintf(stderr, "gzloadindex accepted a gzip file\n");
+        exit(1);
+    }
+    gzclose(file);
+    printf("gzsaveindex(), gzloadindex(), gzpread(): OK\n");
+
+    /* build the index while writing, saved next to the file on close */
+    file = gzopen(fname, "wbi");
+    if (file == NULL || gzindex(file, 65536L) != 0) {
+        fprintf(stderr, "gzindex when writing error\n");
+        exit(1);
+    }
+    if (gzwrite(file, data, 400000) != 400000 ||
+        gzflush(file, Z_FINISH) != Z_OK ||
+        gzwrite(file, data + 400000, (unsigned)len - 400000) !=
+            (int)len - 400000 ||
+        gzclose(file) != Z_OK) {
+        fprintf(stderr, "gzwrite with gzindex error\n");
+        exit(1);
+    }
+    file = gzopen(fname, "rbi");
+    if (file == NULL) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    for (i = 0; i < (int)(sizeof(seeks) / sizeof(seeks[0])); i++) {
+        pos = gzseek(file, seeks[i], SEEK_SET);
+        if (pos != seeks[i] ||
+            gzread(file, got, 10) != 10 || memcmp(got, data + pos, 10)) {
+            fprintf(stderr, "gzseek with written index error at %ld: %s\n",
+                    (long)seeks[i], gzerror(file, &err));
+            exit(1);
+        }
+    }
+    gzclose(file);
+    printf("gzindex() when writing: OK\n");
+
+    remove(sidecar);
+    free(got);
+    free(data);
+#endif
+}
+
+/* ===========================================================================
+ * Test writing BGZF, and reading it using virtual offsets
+ */
+static void test_bgzf(const char *fname) {
+#ifdef NO_GZCOMPRESS
+    fprintf(stderr, "NO_GZCOMPRESS -- gz* functions cannot compress\n");
+#else
+    int err, i;
+    uLong len = 400000L, rand = 1;
+    Byte *data, *got;
+    char sidecar[1024];
+    gzFile file;
+    z_off_t pos;
+    z_off64_t voff[8];
+
+    data = (Byte*)malloc(len);
+    got = (Byte*)malloc(1000);
+    if (data == Z_NULL || got == Z_NULL ||
+        strlen(fname) + 5 > sizeof(sidecar)) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    /* incompressible data, which must be stored, followed by text */
+    for (pos = 0; pos < 100000L; pos++) {
+        rand = rand * 1103515245UL + 12345;
+        data[pos] = (Byte)(rand >> 16);
+    }
+    make_text(data + 100000L, 300000L);
+
+    /* write BGZF, noting the virtual offsets every 50000 bytes */
+    file = gzopen(fname, "wbB");
+    if (file == NULL) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    for (pos = 0; pos < (z_off_t)len; pos += 1000) {
+        if (pos % 50000L == 0)
+            voff[pos / 50000L] = gzvtell(file);
+        if (pos == 123000L)
+            gzflush(file, Z_SYNC_FLUSH);
+        if (gzwrite(file, data + pos, 1000) != 1000) {
+            fprintf(stderr, "gzwrite err: %s\n", gzerror(file, &err));
+            exit(1);
+        }
+    }
+    if (voff[0] != 0 || voff[7] <= voff[6] || gzclose(file) != Z_OK) {
+        fprintf(stderr, "BGZF write error\n");
+        exit(1);
+    }
+
+    /* read it back, checking the virtual offsets along the way */
+    file = gzopen(fname, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    gzindex(file, 1000);
+    for (pos = 0; pos < (z_off_t)len; pos += 1000) {
+        if (pos % 50000L == 0 && gzvtell(file) != voff[pos / 50000L]) {
+            fprintf(stderr, "gzvtell mismatch at %ld\n", (long)pos);
+            exit(1);
+        }
+        if (gzread(file, got, 1000) != 1000 || memcmp(got, data + pos, 1000)) {
+            fprintf(stderr, "gzread BGZF err at %ld: %s\n", (long)pos,
+                    gzerror(file, &err));
+            exit(1);
+        }
+    }
+    if (gzread(file, got, 1) != 0 || gzerror(file, &err) == NULL ||
+        err != Z_OK) {
+        fprintf(stderr, "gzread BGZF at end error\n");
+        exit(1);
+    }
+    strcpy(sidecar, fname);
+    strcat(sidecar, ".zri");
+    err = gzsaveindex(file, sidecar);
+    CHECK_ERR(err, "gzsaveindex");
+
+    /* go to the virtual offsets out of order */
+    for (i = 7; i >= 0; i -= 3)
+        if (gzvseek(file, voff[i]) != 0 || gzread(file, got, 1000) != 1000 ||
+            memcmp(got, data + i * 50000L, 1000)) {
+            fprintf(stderr, "gzvseek error at %d\n", i);
+            exit(1);
+        }
+    gzclose(file);
+
+    /* a virtual offset is not an uncompressed offset, so gzvseek() as the
+       first operation must not use the sidecar index */
+    file = gzopen(fname, "rbi");
+    if (file == NULL) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    if (gzvseek(file, voff[5]) != 0 || gzread(file, got, 1000) != 1000 ||
+        memcmp(got, data + 5 * 50000L, 1000)) {
+        fprintf(stderr, "gzvseek with sidecar index error\n");
+        exit(1);
+    }
+    gzclose(file);
+    printf("gzopen() BGZF, gzvtell(), gzvseek(): OK\n");
+
+    remove(sidecar);
+    free(got);
+    free(data);
+#endif
+}
+
+/* ===========================================================================
+ * Test gzgetline() and gzgetlines(), including a line longer than the buffers
+ */
+static void test_gzlines(const char *fname) {
+#ifdef NO_GZCOMPRESS
+    fprintf(stderr, "NO_GZCOMPRESS -- gz* functions cannot compress\n");
+#else
+    int err, n, i, k, most = 0;
+    uLong len = 200000L, pos;
+    Byte *data;
+    gzFile file;
+    const char *line[16];
+    z_size_t size[16];
+
+    data = (Byte*)malloc(len);
+    if (data == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    make_text(data, len);
+    memset(data + 100000L, 'x', 50000);
+
+    file = gzopen(fname, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    if (gzwrite(file, data, (unsigned)len) != (int)len ||
+        gzclose(file) != Z_OK) {
+        fprintf(stderr, "gzwrite error\n");
+        exit(1);
+    }
+
+    file = gzopen(fname, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    for (i = 0; i < 2; i++) {
+        pos = 0;
+        while ((n = i ? gzgetlines(file, line, size, 16) :
+                        gzgetline(file, line, size)) > 0) {
+            if (n > most)
+                most = n;
+            for (k = 0; k < n; k++) {
+                if (size[k] == 0 || pos + size[k] > len ||
+                    memcmp(line[k], data + pos, size[k]) ||
+                    (line[k][size[k] - 1] != '\n' && pos + size[k] != len)) {
+                    fprintf(stderr, "bad gzgetline at %lu\n", pos);
+                    exit(1);
+                }
+                pos += (uLong)size[k];
+            }
+        }
+        if (n < 0 || pos != len) {
+            fprintf(stderr, "gzgetline err: %s\n", gzerror(file, &err));
+            exit(1);
+        }
+        gzrewind(file);
+    }
+    gzclose(file);
+    if (most < 2) {
+        fprintf(stderr, "gzgetlines returned one line at a time\n");
+        exit(1);
+    }
+    printf("gzgetline(), gzgetlines(): OK\n");
+
+    free(data);
+#endif
+}
+
+/* ===========================================================================
+ * Write an rsyncable gzip file with "y", and return its length in *got
+ */
+static Byte *write_rsync(const char *fname, Byte *data, uLong len,
+                         uLong *got) {
+    Byte *raw;
+    FILE *in;
+    gzFile file;
+
+    file = gzopen(fname, "wby");
+    if (file == NULL || gzwrite(file, data, (unsigned)len) != (int)len ||
+        gzclose(file) != Z_OK) {
+        fprintf(stderr, "gzwrite rsyncable error\n");
+        exit(1);
+    }
+    raw = (Byte*)malloc(len);
+    in = fopen(fname, "rb");
+    if (raw == Z_NULL || in == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    *got = (uLong)fread(raw, 1, len, in);
+    fclose(in);
+    return raw;
+}
+
+/* ===========================================================================
+ * Test that a change early in the data leaves the later output the same
+ */
+static void test_rsync(const char *fname) {
+#ifdef NO_GZCOMPRESS
+    fprintf(stderr, "NO_GZCOMPRESS -- gz* functions cannot compress\n");
+#else
+    int err;
+    uLong len = 1000000L, len1, len2, same;
+    Byte *data, *one, *two;
+    gzFile file;
+
+    data = (Byte*)malloc(len);
+    if (data == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    make_text(data, len);
+    one = write_rsync(fname, data + 100, len - 100, &len1);
+    memcpy(data + 1000, "changed", 7);
+    two = write_rsync(fname, data, len, &len2);
+
+    /* compare the compressed data from the end, before the trailers */
+    same = 0;
+    while (same < len1 - 8 && same < len2 - 8 &&
+           one[len1 - 9 - same] == two[len2 - 9 - same])
+        same++;
+    if (same < len1 / 2) {
+        fprintf(stderr, "rsyncable output differs too much: %lu of %lu\n",
+                same, len1);
+        exit(1);
+    }
+
+    /* check that the second one decompresses to all of the data */
+    free(one);
+    one = (Byte*)malloc(len + 1);
+    if (one == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    file = gzopen(fname, "rb");
+    if (file == NULL || gzread(file, one, (unsigned)len + 1) != (int)len ||
+        memcmp(one, data, len) || gzclose(file) != Z_OK) {
+        fprintf(stderr, "gzread rsyncable err: %s\n", gzerror(file, &err));
+        exit(1);
+    }
+    printf("gzopen() rsyncable: OK\n");
+
+    free(two);
+    free(one);
+    free(data);
+#endif
+}
+
 #endif /* Z_SOLO */
 
 /* ===========================================================================
@@ -490,6 +936,204 @@ static void test_dict_inflate(Byte *compr, uLong comprLen, Byte *uncompr,
     }
 }
 
+/* ===========================================================================
+ * Test deflate() and inflate() with a precomputed dictionary, which must give
+ * the same result as deflateSetDictionary()
+ */
+static void test_dict_made(Byte *compr, uLong comprLen, Byte *uncompr,
+                           uLong uncomprLen) {
+    z_stream c_stream, d_stream;
+    z_dictp dict;
+    Byte *big;
+    uLong len = 40000L, i, used;
+    int err;
+
+    big = (Byte*)calloc(len, 1);
+    if (big == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (i = 0; i < len; i++)
+        big[i] = (Byte)("abcdefghij"[(i * 7 + i / 13) % 10]);
+
+    c_stream.zalloc = zalloc;
+    c_stream.zfree = zfree;
+    c_stream.opaque = (voidpf)0;
+    err = deflateInit(&c_stream, Z_DEFAULT_COMPRESSION);
+    CHECK_ERR(err, "deflateInit");
+    err = deflateMakeDictionary(&c_stream, big, (uInt)len, &dict);
+    CHECK_ERR(err, "deflateMakeDictionary");
+
+    /* compress with the dictionary both ways, into the two halves of compr */
+    for (i = 0; i < 2; i++) {
+        err = i ? deflateUseDictionary(&c_stream, dict) :
+                  deflateSetDictionary(&c_stream, big, (uInt)len);
+        CHECK_ERR(err, "deflate dictionary");
+        c_stream.next_in = big + 20000;
+        c_stream.avail_in = 5000;
+        c_stream.next_out = compr + i * (comprLen / 2);
+        c_stream.avail_out = (uInt)(comprLen / 2);
+        if (deflate(&c_stream, Z_FINISH) != Z_STREAM_END) {
+            fprintf(stderr, "deflate should report Z_STREAM_END\n");
+            exit(1);
+        }
+        used = c_stream.total_out;
+        err = deflateReset(&c_stream);
+        CHECK_ERR(err, "deflateReset");
+    }
+    if (memcmp(compr, compr + comprLen / 2, used)) {
+        fprintf(stderr, "deflateUseDictionary differs\n");
+        exit(1);
+    }
+    err = deflateEnd(&c_stream);
+    CHECK_ERR(err, "deflateEnd");
+
+    /* decompress it */
+    d_stream.zalloc = zalloc;
+    d_stream.zfree = zfree;
+    d_stream.opaque = (voidpf)0;
+    d_stream.next_in = compr;
+    d_stream.avail_in = (uInt)used;
+    err = inflateInit(&d_stream);
+    CHECK_ERR(err, "inflateInit");
+    d_stream.next_out = uncompr;
+    d_stream.avail_out = (uInt)uncomprLen;
+    err = inflate(&d_stream, Z_NO_FLUSH);
+    if (err != Z_NEED_DICT) {
+        fprintf(stderr, "inflate should report Z_NEED_DICT\n");
+        exit(1);
+    }
+    err = inflateUseDictionary(&d_stream, dict);
+    CHECK_ERR(err, "inflateUseDictionary");
+    if (inflate(&d_stream, Z_NO_FLUSH) != Z_STREAM_END ||
+        d_stream.total_out != 5000 || memcmp(uncompr, big + 20000, 5000)) {
+        fprintf(stderr, "bad inflate with precomputed dictionary\n");
+        exit(1);
+    }
+    err = inflateEnd(&d_stream);
+    CHECK_ERR(err, "inflateEnd");
+    err = deflateFreeDictionary(dict);
+    CHECK_ERR(err, "deflateFreeDictionary");
+    free(big);
+    printf("deflateMakeDictionary(), inflateUseDictionary(): OK\n");
+}
+
+/* ===========================================================================
+ * Test deflate() and inflate() with caller-provided workspaces, twice from
+ * the same workspaces, and that a workspace too small is refused
+ */
+static void test_workspace(Byte *compr, uLong comprLen, Byte *uncompr,
+                           uLong uncomprLen) {
+    z_stream c_stream, d_stream;
+    Byte *work;
+    z_size_t csize, dsize;
+    int err, k;
+
+    csize = deflateWorkspaceSize(Z_BEST_SPEED, 12, 5);
+    dsize = inflateWorkspaceSize(12);
+    if (csize == 0 || dsize == 0 || deflateWorkspaceSize(1, 16, 5) != 0 ||
+        deflateWorkspaceSize(Z_DEFAULT_COMPRESSION, 12, 5) != csize) {
+        fprintf(stderr, "bad workspace size\n");
+        exit(1);
+    }
+    work = (Byte*)malloc(csize + dsize);
+    if (work == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    err = deflateInitWorkspace(&c_stream, Z_BEST_SPEED, Z_DEFLATED, 12, 5,
+                               Z_DEFAULT_STRATEGY, work, csize - 1);
+    if (err != Z_MEM_ERROR) {
+        fprintf(stderr, "deflateInitWorkspace should report Z_MEM_ERROR\n");
+        exit(1);
+    }
+
+    for (k = 0; k < 2; k++) {
+        err = deflateInitWorkspace(&c_stream, Z_BEST_SPEED, Z_DEFLATED, 12, 5,
+                                   Z_DEFAULT_STRATEGY, work, csize);
+        CHECK_ERR(err, "deflateInitWorkspace");
+        c_stream.next_in = (z_const unsigned char *)hello;
+        c_stream.avail_in = (uInt)strlen(hello) + 1;
+        c_stream.next_out = compr;
+        c_stream.avail_out = (uInt)comprLen;
+        err = deflate(&c_stream, Z_FINISH);
+        if (err != Z_STREAM_END) {
+            fprintf(stderr, "deflate should report Z_STREAM_END\n");
+            exit(1);
+        }
+        err = deflateEnd(&c_stream);
+        CHECK_ERR(err, "deflateEnd");
+
+        strcpy((char*)uncompr, "garbage");
+        d_stream.next_in = compr;
+        d_stream.avail_in = (uInt)c_stream.total_out;
+        err = inflateInitWorkspace(&d_stream, 12, work + csize, dsize);
+        CHECK_ERR(err, "inflateInitWorkspace");
+        d_stream.next_out = uncompr;
+        d_stream.avail_out = (uInt)uncomprLen;
+        err = inflate(&d_stream, Z_FINISH);
+        if (err != Z_STREAM_END || strcmp((char*)uncompr, hello)) {
+            fprintf(stderr, "bad inflate with workspace\n");
+            exit(1);
+        }
+        err = inflateEnd(&d_stream);
+        CHECK_ERR(err, "inflateEnd");
+    }
+    free(work);
+    printf("deflateInitWorkspace(), inflateInitWorkspace(): OK\n");
+}
+
+#ifndef Z_SOLO
+/* ===========================================================================
+ * Test deflate() and inflate() with the per-thread allocation pools, making
+ * several streams in a row so that later ones reuse the memory
+ */
+static void test_pool(Byte *compr, uLong comprLen, Byte *uncompr,
+                      uLong uncomprLen) {
+    z_stream c_stream, d_stream;
+    int err, k;
+
+    for (k = 0; k < 3; k++) {
+        c_stream.zalloc = Z_POOL_ALLOC;
+        c_stream.zfree = Z_NULL;
+        c_stream.opaque = (voidpf)0;
+        err = deflateInit(&c_stream, Z_DEFAULT_COMPRESSION);
+        CHECK_ERR(err, "deflateInit");
+        c_stream.next_in = (z_const unsigned char *)hello;
+        c_stream.avail_in = (uInt)strlen(hello) + 1;
+        c_stream.next_out = compr;
+        c_stream.avail_out = (uInt)comprLen;
+        err = deflate(&c_stream, Z_FINISH);
+        if (err != Z_STREAM_END) {
+            fprintf(stderr, "deflate should report Z_STREAM_END\n");
+            exit(1);
+        }
+        err = deflateEnd(&c_stream);
+        CHECK_ERR(err, "deflateEnd");
+
+        strcpy((char*)uncompr, "garbage");
+        d_stream.zalloc = Z_POOL_ALLOC;
+        d_stream.zfree = Z_NULL;
+        d_stream.opaque = (voidpf)0;
+        d_stream.next_in = compr;
+        d_stream.avail_in = (uInt)c_stream.total_out;
+        err = inflateInit(&d_stream);
+        CHECK_ERR(err, "inflateInit");
+        d_stream.next_out = uncompr;
+        d_stream.avail_out = (uInt)uncomprLen;
+        err = inflate(&d_stream, Z_FINISH);
+        if (err != Z_STREAM_END || strcmp((char*)uncompr, hello)) {
+            fprintf(stderr, "bad inflate with pool\n");
+            exit(1);
+        }
+        err = inflateEnd(&d_stream);
+        CHECK_ERR(err, "inflateEnd");
+    }
+    zlibPoolRelease();
+    printf("Z_POOL_ALLOC, zlibPoolRelease(): OK\n");
+}
+#endif
+
 /* ===========================================================================
  * Usage:  example [output.gz  [input.gz]]
  */
@@ -530,6 +1174,10 @@ int main(int argc, char *argv[]) {
 
     test_gzio((argc > 1 ? argv[1] : TESTFILE),
               uncompr, uncomprLen);
+    test_gzindex((argc > 1 ? argv[1] : TESTFILE));
+    test_bgzf((argc > 1 ? argv[1] : TESTFILE));
+    test_gzlines((argc > 1 ? argv[1] : TESTFILE));
+    test_rsync((argc > 1 ? argv[1] : TESTFILE));
 #endif
 
     test_deflate(compr, comprLen);
@@ -544,6 +1192,11 @@ int main(int argc, char *argv[]) {
 
     test_dict_deflate(compr, comprLen);
     test_dict_inflate(compr, comprLen, uncompr, uncomprLen);
+    test_dict_made(compr, comprLen, uncompr, uncomprLen);
+    test_workspace(compr, comprLen, uncompr, uncomprLen);
+#ifndef Z_SOLO
+    test_pool(compr, comprLen, uncompr, uncomprLen);
+#endif
 
     free(compr);
     free(uncompr);
@@ -46,11 +46,15 @@
 #  define deflateBound          z_deflateBound
 #  define deflateCopy           z_deflateCopy
 #  define deflateEnd            z_deflateEnd
+#  define deflateFreeDictionary z_deflateFreeDictionary
 #  define deflateGetDictionary  z_deflateGetDictionary
 #  define deflateInit           z_deflateInit
 #  define deflateInit2          z_deflateInit2
 #  define deflateInit2_         z_deflateInit2_
+#  define deflateInitWorkspace  z_deflateInitWorkspace
+#  define deflateInitWorkspace_ z_deflateInitWorkspace_
 #  define deflateInit_          z_deflateInit_
+#  define deflateMakeDictionary z_deflateMakeDictionary
 #  define deflateParams         z_deflateParams
 #  define deflatePending        z_deflatePending
 #  define deflatePrime          z_deflatePrime
@@ -59,6 +63,8 @@
 #  define deflateSetDictionary  z_deflateSetDictionary
 #  define deflateSetHeader      z_deflateSetHeader
 #  define deflateTune           z_deflateTune
+#  define deflateUseDictionary  z_deflateUseDictionary
+#  define deflateWorkspaceSize  z_deflateWorkspaceSize
 #  define deflate_copyright     z_deflate_copyright
 #  define get_crc_table         z_get_crc_table
 #  ifndef Z_SOLO
@@ -79,7 +85,11 @@
 #    define gzfwrite              z_gzfwrite
 #    define gzgetc                z_gzgetc
 #    define gzgetc_               z_gzgetc_
+#    define gzgetline             z_gzgetline
+#    define gzgetlines            z_gzgetlines
 #    define gzgets                z_gzgets
+#    define gzindex               z_gzindex
+#    define gzloadindex           z_gzloadindex
 #    define gzoffset              z_gzoffset
 #    define gzoffset64            z_gzoffset64
 #    define gzopen                z_gzopen
@@ -87,11 +97,13 @@
 #    ifdef _WIN32
 #      define gzopen_w              z_gzopen_w
 #    endif
+#    define gzpread               z_gzpread
 #    define gzprintf              z_gzprintf
 #    define gzputc                z_gzputc
 #    define gzputs                z_gzputs
 #    define gzread                z_gzread
 #    define gzrewind              z_gzrewind
+#    define gzsaveindex           z_gzsaveindex
 #    define gzseek                z_gzseek
 #    define gzseek64              z_gzseek64
 #    define gzsetparams           z_gzsetparams
@@ -99,6 +111,8 @@
 #    define gztell64              z_gztell64
 #    define gzungetc              z_gzungetc
 #    define gzvprintf             z_gzvprintf
+#    define gzvseek               z_gzvseek
+#    define gzvtell               z_gzvtell
 #    define gzwrite               z_gzwrite
 #  endif
 #  define inflate               z_inflate
@@ -114,6 +128,8 @@
 #  define inflateInit           z_inflateInit
 #  define inflateInit2          z_inflateInit2
 #  define inflateInit2_         z_inflateInit2_
+#  define inflateInitWorkspace  z_inflateInitWorkspace
+#  define inflateInitWorkspace_ z_inflateInitWorkspace_
 #  define inflateInit_          z_inflateInit_
 #  define inflateMark           z_inflateMark
 #  define inflatePrime          z_inflatePrime
@@ -124,7 +140,9 @@
 #  define inflateSync           z_inflateSync
 #  define inflateSyncPoint      z_inflateSyncPoint
 #  define inflateUndermine      z_inflateUndermine
+#  define inflateUseDictionary  z_inflateUseDictionary
 #  define inflateValidate       z_inflateValidate
+#  define inflateWorkspaceSize  z_inflateWorkspaceSize
 #  define inflate_copyright     z_inflate_copyright
 #  define inflate_fast          z_inflate_fast
 #  define inflate_table         z_inflate_table
@@ -136,9 +154,15 @@
 #  ifndef Z_SOLO
 #    define zcalloc               z_zcalloc
 #    define zcfree                z_zcfree
+#    define zpalloc               z_zpalloc
+#    define zpfree                z_zpfree
 #  endif
 #  define zlibCompileFlags      z_zlibCompileFlags
+#  define zlibPoolRelease       z_zlibPoolRelease
 #  define zlibVersion           z_zlibVersion
+#  define zwalloc               z_zwalloc
+#  define zwfree                z_zwfree
+#  define zwinit                z_zwinit
 
 /* all zlib typedefs in zlib.h and zconf.h */
 #  define Byte                  z_Byte
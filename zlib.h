@@ -130,6 +130,8 @@ typedef struct gz_header_s {
 
 typedef gz_header FAR *gz_headerp;
 
+typedef struct z_dictionary_s FAR *z_dictp;   /* see deflateMakeDictionary() */
+
 /*
      The application must update next_in and avail_in when avail_in has dropped
    to zero.  It must update next_out and avail_out when avail_out has dropped
@@ -148,6 +150,17 @@ typedef gz_header FAR *gz_headerp;
    Z_NULL on entry to the initialization function, they are set to internal
    routines that use the standard library functions malloc() and free().
 
+     If instead zalloc is Z_POOL_ALLOC on entry to the initialization function,
+   then zalloc and zfree are set to internal routines that keep the memory
+   freed by a stream in per-thread pools, for reuse by the next stream made by
+   the same thread.  That avoids malloc() and free() when many streams with
+   the same parameters are made one after another.  zfree and opaque are
+   ignored in that case.  If zlib is compiled with Z_POOL defined, then the
+   pools are also used when zalloc and zfree are Z_NULL.  zlibPoolRelease()
+   frees the memory held in the calling thread's pools, which should be done
+   before a thread that used them exits.  If the compiler does not provide
+   thread-local storage, Z_POOL_ALLOC is the same as Z_NULL.
+
      On 16-bit systems, the functions zalloc and zfree must be able to allocate
    exactly 65536 bytes, but will not be required to allocate more than this if
    the symbol MAXSEG_64K is defined (see zconf.h).  WARNING: On MSDOS, pointers
@@ -211,6 +224,9 @@ typedef gz_header FAR *gz_headerp;
 
 #define Z_NULL  0  /* for initializing zalloc, zfree, opaque */
 
+#define Z_POOL_ALLOC ((alloc_func)1)
+/* for initializing zalloc to use the per-thread pools, see above */
+
 #define zlib_version zlibVersion()
 /* for compatibility with versions < 1.0.2 */
 
@@ -611,6 +627,43 @@ ZEXTERN int ZEXPORT deflateInit2(z_streamp strm,
    compression: this will be done by deflate().
 */
 
+ZEXTERN z_size_t ZEXPORT deflateWorkspaceSize(int level, int windowBits,
+                                              int memLevel);
+/*
+     Returns the number of bytes of workspace needed by deflateInitWorkspace()
+   for the given level, windowBits, and memLevel, which have the same meanings
+   as for deflateInit2().  This includes room to align each of the deflate
+   allocations to a 64-byte cache line, wherever the workspace starts.  Zero is
+   returned if a parameter is invalid.
+*/
+
+/*
+ZEXTERN int ZEXPORT deflateInitWorkspace(z_streamp strm,
+                                         int level,
+                                         int method,
+                                         int windowBits,
+                                         int memLevel,
+                                         int strategy,
+                                         voidp work,
+                                         z_size_t size);
+
+     This is deflateInit2() with the memory for the stream provided by the
+   caller in work[0..size-1], instead of being allocated with zalloc.  size
+   must be at least deflateWorkspaceSize(level, windowBits, memLevel).  All of
+   the deflate allocations are made from the workspace, with no calls of
+   malloc() or of the application's allocator, and strm->zalloc, strm->zfree,
+   and strm->opaque are set to manage the workspace.  Those must not be changed
+   while the stream is in use.  deflateEnd() frees nothing, after which the
+   workspace can be used again, or released by the application.  The same
+   workspace must not be used by more than one stream at a time.  Functions
+   that allocate more memory for the stream, such as deflateCopy() with strm
+   as the source, will return Z_MEM_ERROR unless size was made large enough
+   for them as well.
+
+     deflateInitWorkspace returns the same values as deflateInit2(), where
+   Z_MEM_ERROR means that size is too small.
+*/
+
 ZEXTERN int ZEXPORT deflateSetDictionary(z_streamp strm,
                                          const Bytef *dictionary,
                                          uInt  dictLength);
@@ -677,6 +730,47 @@ ZEXTERN int ZEXPORT deflateGetDictionary(z_streamp strm,
    stream state is inconsistent.
 */
 
+ZEXTERN int ZEXPORT deflateMakeDictionary(z_streamp strm,
+                                          const Bytef *dictionary,
+                                          uInt  dictLength,
+                                          z_dictp *dict);
+/*
+     Makes a precomputed dictionary *dict from the dictionary, for use by
+   deflateUseDictionary() and inflateUseDictionary().  This does the work of
+   deflateSetDictionary() once, saving the window and the hash tables that it
+   builds, so that setting the same dictionary on many streams is a copy
+   instead of hashing the dictionary every time.  strm must have just been
+   initialized or reset, and is used for its windowBits and memLevel, for the
+   allocation functions, and to hash the dictionary, after which it is reset.
+   The precomputed dictionary can only be used by deflate streams with the
+   same windowBits and memLevel as strm.  It is not changed after it is made,
+   so it can be used by any number of streams in any number of threads at the
+   same time.
+
+     deflateMakeDictionary returns Z_OK on success, Z_MEM_ERROR if there was
+   not enough memory, or Z_STREAM_ERROR if a parameter is invalid, if strm is
+   for gzip, or if strm is not at its start.
+*/
+
+ZEXTERN int ZEXPORT deflateUseDictionary(z_streamp strm, z_dictp dict);
+/*
+     Sets the dictionary for strm to the precomputed dictionary dict, with the
+   same result as deflateSetDictionary() with the dictionary that dict was
+   made from.  deflateUseDictionary may be called where deflateSetDictionary
+   could be called, except that strm must not already have a dictionary.
+
+     deflateUseDictionary returns Z_OK on success, or Z_STREAM_ERROR if a
+   parameter is invalid, if it is called at the wrong time, or if dict was made
+   for a different windowBits or memLevel.
+*/
+
+ZEXTERN int ZEXPORT deflateFreeDictionary(z_dictp dict);
+/*
+     Frees the precomputed dictionary dict, using the free function of the
+   stream it was made with.  dict must not be in use by another thread.
+   deflateFreeDictionary returns Z_OK, or Z_STREAM_ERROR if dict is Z_NULL.
+*/
+
 ZEXTERN int ZEXPORT deflateCopy(z_streamp dest,
                                 z_streamp source);
 /*
@@ -888,6 +982,31 @@ ZEXTERN int ZEXPORT inflateInit2(z_streamp strm,
    deferred until inflate() is called.
 */
 
+ZEXTERN z_size_t ZEXPORT inflateWorkspaceSize(int windowBits);
+/*
+     Returns the number of bytes of workspace needed by inflateInitWorkspace()
+   for windowBits, which has the same meaning as for inflateInit2().  If
+   windowBits requests the window size from the zlib header, then the size for
+   a 32K window is returned.  Zero is returned if windowBits is invalid.
+*/
+
+/*
+ZEXTERN int ZEXPORT inflateInitWorkspace(z_streamp strm,
+                                         int windowBits,
+                                         voidp work,
+                                         z_size_t size);
+
+     This is inflateInit2() with the memory for the stream provided by the
+   caller in work[0..size-1], instead of being allocated with zalloc.  size
+   must be at least inflateWorkspaceSize(windowBits).  This is otherwise the
+   same as deflateInitWorkspace(), including the window that inflate()
+   allocates when it is first needed.  inflateReset2() may be used with
+   windowBits no larger than the one the workspace was sized for.
+
+     inflateInitWorkspace returns the same values as inflateInit2(), where
+   Z_MEM_ERROR means that size is too small.
+*/
+
 ZEXTERN int ZEXPORT inflateSetDictionary(z_streamp strm,
                                          const Bytef *dictionary,
                                          uInt  dictLength);
@@ -926,6 +1045,22 @@ ZEXTERN int ZEXPORT inflateGetDictionary(z_streamp strm,
    stream state is inconsistent.
 */
 
+ZEXTERN int ZEXPORT inflateUseDictionary(z_streamp strm, z_dictp dict);
+/*
+     Sets the dictionary for strm from the precomputed dictionary dict, with
+   the same result as inflateSetDictionary() with the dictionary that dict was
+   made from by deflateMakeDictionary(), but without recomputing the Adler-32
+   value of the dictionary for each stream.  Only the last window size bytes of
+   the dictionary for the windowBits dict was made with are kept, which is all
+   that a deflate stream using the dictionary with those windowBits can refer
+   to.  Using dict does not change it, so many inflate streams can use it at
+   the same time.
+
+     inflateUseDictionary returns the same values as inflateSetDictionary(),
+   where Z_DATA_ERROR means that dict was not made from the dictionary that the
+   zlib stream requires.
+*/
+
 ZEXTERN int ZEXPORT inflateSync(z_streamp strm);
 /*
      Skips invalid compressed data until a possible full flush point (see above
@@ -1209,7 +1344,8 @@ ZEXTERN uLong ZEXPORT zlibCompileFlags(void);
     Operation variations (changes in library functionality):
      20: PKZIP_BUG_WORKAROUND -- slightly more permissive inflate
      21: FASTEST -- deflate algorithm with only one, lowest compression level
-     22,23: 0 (reserved)
+     22: Z_POOL -- default allocation uses per-thread pools (see Z_POOL_ALLOC)
+     23: 0 (reserved)
 
     The sprintf variant used by gzprintf (zero is best):
      24: 0 = vs*, 1 = s* -- 1 means limited to 20 arguments after the format
@@ -1222,6 +1358,13 @@ ZEXTERN uLong ZEXPORT zlibCompileFlags(void);
 
 #ifndef Z_SOLO
 
+ZEXTERN void ZEXPORT zlibPoolRelease(void);
+/*
+     Frees the memory held for reuse in the calling thread's allocation pools
+   (see Z_POOL_ALLOC).  Streams in use are not affected.  Memory that they free
+   later goes back into the pools.
+*/
+
                         /* utility functions */
 
 /*
@@ -1325,6 +1468,29 @@ ZEXTERN gzFile ZEXPORT gzopen(const char *path, const char *mode);
    "x" when writing will create the file exclusively, which fails if the file
    already exists.  On systems that support it, the addition of "e" when
    reading or writing will set the flag to close the file on an execve() call.
+   The addition of "i" when reading will load the index saved by gzsaveindex()
+   in a file with the same path and ".zri" appended, if there is one, so that
+   gzseek() can use it.  The addition of "i" when writing will save the index
+   built by gzindex() to that file when the file is closed.  (See gzindex()
+   below.)
+
+     The addition of "B" when writing or appending will write the data in the
+   BGZF blocked gzip format, as a series of gzip members each with at most
+   65280 bytes of uncompressed data and at most 64K bytes of compressed data,
+   and with an extra field in each header giving the size of the member.  The
+   buffer size set by gzbuffer() is not used.  gzflush() with any flush value
+   ends the current member, and gzclose() writes an empty member at the end,
+   as BGZF requires.  When reading, BGZF members are recognized and decoded
+   with less per-member overhead than other gzip members, with no mode needed.
+   (See gzvtell() below.)
+
+     The addition of "y" when writing will make the compressed data
+   rsyncable, for efficient transfer or deduplication of successive versions
+   of a file.  A rolling hash of the uncompressed data determines where to do a
+   full flush, as for Z_FULL_FLUSH, on average every 64K bytes.  Since those
+   points depend only on the nearby data, a change to the input changes only
+   the compressed data around it, with the remaining compressed data the same
+   as before.  This costs a little compression.  "y" is ignored for BGZF.
 
      These functions, as well as gzip, will read and decode a sequence of gzip
    streams in a file.  The append function of gzopen() can be used to create
@@ -1384,6 +1550,88 @@ ZEXTERN int ZEXPORT gzbuffer(gzFile file, unsigned size);
    too late.
 */
 
+ZEXTERN int ZEXPORT gzindex(gzFile file, z_off64_t span);
+/*
+     Build an index of access points while reading file, so that gzseek()
+   can resume decompression near the requested position instead of
+   decompressing from the start of the file or from the current position.  An
+   access point is recorded at the first deflate block boundary at least span
+   bytes of uncompressed data after the previous one.  Each access point costs
+   up to 32K bytes of memory for the uncompressed data that precedes it, so
+   span should be much larger than that, e.g. 1M bytes or more.  A span of
+   zero stops adding access points, but keeps the ones already recorded.
+
+     Access points are only recorded for data that has been read, so a seek
+   backwards, or a seek forwards into data previously read, is where the index
+   helps.  Recording access points decompresses a block at a time, which is
+   slightly slower than reading without an index.  The index is freed when the
+   file is closed.
+
+     gzindex() can also be used when writing a new file, which builds the
+   index while compressing, with no need to read the file back later.  Then an
+   access point is recorded every span bytes of uncompressed data, where the
+   current deflate block is ended and the window saved, or at the start of the
+   next member when writing BGZF, for which no window is needed.  Ending a
+   block costs a little compression.  The index can be saved when the file is
+   closed by using "i" in the gzopen() mode.
+
+     gzindex() returns 0 on success, or -1 if file was not opened for reading
+   or writing, if it was opened for appending or transparent writing, or if
+   span is negative.
+*/
+
+ZEXTERN int ZEXPORT gzsaveindex(gzFile file, const char *path);
+/*
+     Save the access points recorded for file to a new index file at path.
+   The windows of uncompressed data are compressed, which usually reduces them
+   to a few K bytes each.  The index file records the length of the compressed
+   file it was made for.  If path is the path of file with ".zri" appended,
+   then opening file with "i" in the mode will load the index automatically.
+
+     gzsaveindex returns Z_OK on success, Z_STREAM_ERROR if file was not opened
+   for reading, Z_ERRNO if there was an error writing the index file, or
+   Z_MEM_ERROR if there was not enough memory.
+*/
+
+ZEXTERN int ZEXPORT gzloadindex(gzFile file, const char *path);
+/*
+     Replace the access points for file with those in the index file at path
+   that was written by gzsaveindex().  The windows are kept compressed in
+   memory, and are decompressed only when gzseek() resumes decompression at
+   that access point.  Loading an index is fast, so a large file can be read
+   randomly right after opening it.  gzindex() can still be used to record
+   more access points past the last one loaded.
+
+     gzloadindex returns Z_OK on success, Z_STREAM_ERROR if file was not opened
+   for reading, Z_ERRNO if there was an error reading the index file,
+   Z_DATA_ERROR if it is not a valid index or was made for a compressed file of
+   a different length, or Z_MEM_ERROR if there was not enough memory.  The
+   previous access points are retained if there is an error.
+*/
+
+ZEXTERN int ZEXPORT gzpread(gzFile file, voidp buf, unsigned len,
+                            z_off64_t offset);
+/*
+     Read and decompress up to len uncompressed bytes starting at offset in
+   the uncompressed data of file into buf, without using or changing the
+   current position or any other state of file.  Decompression starts at the
+   last access point at or before offset recorded by gzindex() or loaded by
+   gzloadindex(), or at the start of the file if there is none.  Each call
+   uses its own decompression engine and reads the file with pread(), so
+   gzpread() can be called on the same file from several threads at once, as
+   long as no other function is using file at the same time, since those can
+   add access points.  Unlike gzread(), the gzip trailers of members entered
+   from an access point are not checked.
+
+     gzpread returns the number of bytes read, which is less than len only if
+   the end of the uncompressed data is reached.  On error, gzpread returns
+   Z_STREAM_ERROR if file was not opened for reading, if len does not fit in an
+   int, or if there is no pread() on this system, Z_ERRNO if there was an error
+   reading the file, Z_DATA_ERROR if the compressed data is invalid,
+   Z_BUF_ERROR if it ends prematurely, or Z_MEM_ERROR if out of memory.  These
+   errors are not saved for gzerror().
+*/
+
 ZEXTERN int ZEXPORT gzsetparams(gzFile file, int level, int strategy);
 /*
      Dynamically update the compression level and strategy for file.  See the
@@ -1508,6 +1756,37 @@ ZEXTERN char * ZEXPORT gzgets(gzFile file, char *buf, int len);
    buf are indeterminate.
 */
 
+ZEXTERN int ZEXPORT gzgetline(gzFile file, const char **line, z_size_t *len);
+/*
+     Read and decompress the next line from file, setting *line to point to
+   the line and *len to its length, without copying it to a user buffer.  The
+   line includes the terminating newline character, except for a last line in
+   the file that does not end with one.  The line is not null-terminated, and
+   may contain zeros.  There is no limit on the length of a line.
+
+     *line points into the internal output buffer when the line is entirely in
+   that buffer, and otherwise to an internal copy assembled from successive
+   buffers.  Either way, the line remains valid only until the next operation
+   on file, and must not be modified.
+
+     gzgetline returns 1 if a line was read, 0 at end-of-file, or -1 in case of
+   error.
+*/
+
+ZEXTERN int ZEXPORT gzgetlines(gzFile file, const char **lines,
+                               z_size_t *lens, int max);
+/*
+     Read and decompress up to max lines from file, as for gzgetline(), with
+   the pointers to and lengths of the lines saved in lines[] and lens[].  The
+   first line is read as by gzgetline(), decompressing more data as needed.
+   The remaining lines are those that are complete in the output buffer after
+   that, so that all of the lines are returned without decompressing any more
+   data.  The lines remain valid only until the next operation on file.
+
+     gzgetlines returns the number of lines read, which is at least one if not
+   at end-of-file, 0 at end-of-file, or -1 in case of error.
+*/
+
 ZEXTERN int ZEXPORT gzputc(gzFile file, int c);
 /*
      Compress and write c, converted to an unsigned char, into file.  gzputc
@@ -1560,9 +1839,9 @@ ZEXTERN z_off_t ZEXPORT gzseek(gzFile file,
    the value SEEK_END is not supported.
 
      If the file is opened for reading, this function is emulated but can be
-   extremely slow.  If the file is opened for writing, only forward seeks are
-   supported; gzseek then compresses a sequence of zeroes up to the new
-   starting position.
+   extremely slow, unless gzindex() has been used to record access points.  If
+   the file is opened for writing, only forward seeks are supported; gzseek
+   then compresses a sequence of zeroes up to the new starting position.
 
      gzseek returns the resulting offset location as measured in bytes from
    the beginning of the uncompressed stream, or -1 in case of error, in
@@ -1598,6 +1877,39 @@ ZEXTERN z_off_t ZEXPORT gzoffset(gzFile file);
    be used for a progress indicator.  On error, gzoffset() returns -1.
 */
 
+ZEXTERN z_off64_t ZEXPORT gzvtell(gzFile file);
+/*
+     Return the current virtual offset of file, as used for BGZF files.  The
+   virtual offset is the offset of the current gzip member in the file, shifted
+   up 16 bits, plus the offset within the uncompressed data of that member.
+   When writing, file must have been opened with "B", and the virtual offset is
+   of the next byte to be written.  When reading, the virtual offset is of the
+   next byte to be read, and can be used later with gzvseek().  That works for
+   any gzip file whose members each have less than 64K bytes of uncompressed
+   data, such as BGZF files.
+
+     gzvtell() returns -1 if file is neither reading gzip data nor writing
+   BGZF, if the offset within the member does not fit in 16 bits, or if a
+   pending gzseek() would leave the current member, until the next read or
+   write.
+*/
+
+ZEXTERN int ZEXPORT gzvseek(gzFile file, z_off64_t offset);
+/*
+     Set the next byte to be read from file, which must be open for reading,
+   to the virtual offset offset, as returned by gzvtell() on this file or as
+   recorded in a BGZF index.  The gzip member at the offset is decompressed
+   starting with the next read, skipping the uncompressed data before the
+   offset in that member.  Since the uncompressed position of that member is
+   not known, gztell() will return offsets relative to the start of that
+   member, gzseek() will go to offsets relative to that as well, and any access
+   points added by gzindex() or gzloadindex() are discarded, with no more
+   added.  gzrewind() will return to the normal positioning.
+
+     gzvseek() returns 0 on success, or -1 if file is not open for reading, is
+   not gzip data, has an error, or if the file offset could not be set.
+*/
+
 ZEXTERN int ZEXPORT gzeof(gzFile file);
 /*
      Return true (1) if the end-of-file indicator for file has been set while
@@ -1798,6 +2110,16 @@ ZEXTERN int ZEXPORT inflateBackInit_(z_streamp strm, int windowBits,
                                      unsigned char FAR *window,
                                      const char *version,
                                      int stream_size);
+ZEXTERN int ZEXPORT deflateInitWorkspace_(z_streamp strm, int level,
+                                          int method, int windowBits,
+                                          int memLevel, int strategy,
+                                          voidp work, z_size_t size,
+                                          const char *version,
+                                          int stream_size);
+ZEXTERN int ZEXPORT inflateInitWorkspace_(z_streamp strm, int windowBits,
+                                          voidp work, z_size_t size,
+                                          const char *version,
+                                          int stream_size);
 #ifdef Z_PREFIX_SET
 #  define z_deflateInit(strm, level) \
           deflateInit_((strm), (level), ZLIB_VERSION, (int)sizeof(z_stream))
@@ -1812,6 +2134,14 @@ ZEXTERN int ZEXPORT inflateBackInit_(z_streamp strm, int windowBits,
 #  define z_inflateBackInit(strm, windowBits, window) \
           inflateBackInit_((strm), (windowBits), (window), \
                            ZLIB_VERSION, (int)sizeof(z_stream))
+#  define z_deflateInitWorkspace(strm, level, method, windowBits, \
+                                 memLevel, strategy, work, size) \
+          deflateInitWorkspace_((strm), (level), (method), (windowBits), \
+                                (memLevel), (strategy), (work), (size), \
+                                ZLIB_VERSION, (int)sizeof(z_stream))
+#  define z_inflateInitWorkspace(strm, windowBits, work, size) \
+          inflateInitWorkspace_((strm), (windowBits), (work), (size), \
+                                ZLIB_VERSION, (int)sizeof(z_stream))
 #else
 #  define deflateInit(strm, level) \
           deflateInit_((strm), (level), ZLIB_VERSION, (int)sizeof(z_stream))
@@ -1826,6 +2156,14 @@ ZEXTERN int ZEXPORT inflateBackInit_(z_streamp strm, int windowBits,
 #  define inflateBackInit(strm, windowBits, window) \
           inflateBackInit_((strm), (windowBits), (window), \
                            ZLIB_VERSION, (int)sizeof(z_stream))
+#  define deflateInitWorkspace(strm, level, method, windowBits, \
+                                 memLevel, strategy, work, size) \
+          deflateInitWorkspace_((strm), (level), (method), (windowBits), \
+                                (memLevel), (strategy), (work), (size), \
+                                ZLIB_VERSION, (int)sizeof(z_stream))
+#  define inflateInitWorkspace(strm, windowBits, work, size) \
+          inflateInitWorkspace_((strm), (windowBits), (work), (size), \
+                                ZLIB_VERSION, (int)sizeof(z_stream))
 #endif
 
 #ifndef Z_SOLO
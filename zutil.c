@@ -85,6 +85,9 @@ uLong ZEXPORT zlibCompileFlags(void) {
 #ifdef FASTEST
     flags += 1L << 21;
 #endif
+#ifdef Z_POOL
+    flags += 1L << 22;
+#endif
 #if defined(STDC) || defined(Z_HAVE_STDARG_H)
 #  ifdef NO_vsnprintf
     flags += 1L << 25;
@@ -166,6 +169,51 @@ void ZLIB_INTERNAL zmemzero(Bytef* dest, uInt len) {
 }
 #endif
 
+/* Set up the workspace work[0..size-1] for zwalloc() and zwfree(), and
+   return the opaque pointer for them, or Z_NULL if size is too small. The
+   allocations start at a multiple of ZWORK_ALIGN, wherever work is. */
+voidpf ZLIB_INTERNAL zwinit(voidpf work, z_size_t size) {
+    struct z_work_s FAR *ws;
+    Bytef *next = (Bytef *)work;
+    z_size_t pad;
+
+    if (work == Z_NULL || size < ZWORK_BASE)
+        return Z_NULL;
+    pad = ((z_size_t)0 - (z_size_t)next) & (ZWORK_ALIGN - 1);
+    ws = (struct z_work_s FAR *)(next + pad);
+    ws->next = next + pad + ZWORK_ROUND(sizeof(struct z_work_s));
+    ws->end = next + size;
+    ws->last = Z_NULL;
+    ws->undo = Z_NULL;
+    return (voidpf)ws;
+}
+
+/* Allocate items * size bytes from the workspace. */
+voidpf ZLIB_INTERNAL zwalloc(voidpf opaque, unsigned items, unsigned size) {
+    struct z_work_s FAR *ws = (struct z_work_s FAR *)opaque;
+    z_size_t len = ZWORK_ROUND((z_size_t)items * size);
+
+    if (len > (z_size_t)(ws->end - ws->next))
+        return Z_NULL;
+    ws->undo = ws->next;
+    ws->last = (voidpf)ws->next;
+    ws->next += len;
+    return ws->last;
+}
+
+/* Free memory allocated from the workspace. Only the most recent allocation
+   is given back, so that a window freed and reallocated by inflateReset2()
+   does not use up the workspace. Anything else is released only when the
+   workspace is no longer in use. */
+void ZLIB_INTERNAL zwfree(voidpf opaque, voidpf ptr) {
+    struct z_work_s FAR *ws = (struct z_work_s FAR *)opaque;
+
+    if (ptr != Z_NULL && ptr == ws->last) {
+        ws->next = ws->undo;
+        ws->last = Z_NULL;
+    }
+}
+
 #ifndef Z_SOLO
 
 #ifdef SYS16BIT
@@ -284,16 +332,135 @@ extern void free(voidpf ptr);
 #endif
 
 voidpf ZLIB_INTERNAL zcalloc(voidpf opaque, unsigned items, unsigned size) {
+#if defined(Z_POOL) && defined(Z_TLS)
+    return zpalloc(opaque, items, size);
+#else
     (void)opaque;
     return sizeof(uInt) > 2 ? (voidpf)malloc(items * size) :
                               (voidpf)calloc(items, size);
+#endif
 }
 
 void ZLIB_INTERNAL zcfree(voidpf opaque, voidpf ptr) {
+#if defined(Z_POOL) && defined(Z_TLS)
+    zpfree(opaque, ptr);
+#else
     (void)opaque;
     free(ptr);
+#endif
 }
 
 #endif /* MY_ZCALLOC */
 
+#ifdef Z_TLS
+
+/* Each thread keeps the blocks freed by zpfree() for reuse by zpalloc(), in
+   up to POOL_SIZES lists of blocks of the same size, with up to POOL_KEEP
+   blocks in each list. zlib asks for the same few sizes over and over for
+   streams with the same parameters, so a new stream gets its memory from the
+   lists with no calls of malloc() and no locks. A block freed by a different
+   thread than the one that allocated it simply goes to the freeing thread's
+   lists. The memory is not zeroed, since zlib does not need it to be. */
+#define POOL_SIZES 8
+#define POOL_KEEP 4
+
+/* header in front of each block, sized to keep the block aligned */
+typedef union z_block_u {
+    struct {
+        z_size_t size;              /* size of the block after the header */
+        union z_block_u FAR *next;  /* next free block in the list */
+    } h;
+    unsigned char align[16];
+    long double pad;
+} z_block;
+
+local Z_TLS struct {
+    z_size_t size;                  /* size of the blocks in the list */
+    unsigned count;                 /* number of blocks in the list */
+    z_block FAR *list;              /* free blocks */
+} pool[POOL_SIZES];
+
+voidpf ZLIB_INTERNAL zpalloc(voidpf opaque, unsigned items, unsigned size) {
+    z_size_t len = (z_size_t)items * size;
+    z_block FAR *block;
+    int k;
+
+    (void)opaque;
+    for (k = 0; k < POOL_SIZES; k++)
+        if (pool[k].size == len && pool[k].count) {
+            block = pool[k].list;
+            pool[k].list = block->h.next;
+            pool[k].count--;
+            return (voidpf)(block + 1);
+        }
+    block = (z_block FAR *)malloc(sizeof(z_block) + len);
+    if (block == NULL)
+        return Z_NULL;
+    block->h.size = len;
+    return (voidpf)(block + 1);
+}
+
+void ZLIB_INTERNAL zpfree(voidpf opaque, voidpf ptr) {
+    z_block FAR *block;
+    int k, empty = -1;
+
+    (void)opaque;
+    if (ptr == Z_NULL)
+        return;
+    block = (z_block FAR *)ptr - 1;
+    for (k = 0; k < POOL_SIZES; k++) {
+        if (pool[k].size == block->h.size)
+            break;
+        if (empty < 0 && pool[k].count == 0)
+            empty = k;
+    }
+    if (k == POOL_SIZES) {
+        if (empty < 0) {
+            free(block);
+            return;
+        }
+        k = empty;
+        pool[k].size = block->h.size;
+    }
+    if (pool[k].count == POOL_KEEP) {
+        free(block);
+        return;
+    }
+    block->h.next = pool[k].list;
+    pool[k].list = block;
+    pool[k].count++;
+}
+
+/* ========================================================================= */
+void ZEXPORT zlibPoolRelease(void) {
+    z_block FAR *block;
+    int k;
+
+    for (k = 0; k < POOL_SIZES; k++) {
+        while ((block = pool[k].list) != NULL) {
+            pool[k].list = block->h.next;
+            free(block);
+        }
+        pool[k].size = 0;
+        pool[k].count = 0;
+    }
+}
+
+#else /* !Z_TLS */
+
+/* no thread-local storage -- allocate without pooling */
+
+voidpf ZLIB_INTERNAL zpalloc(voidpf opaque, unsigned items, unsigned size) {
+    return zcalloc(opaque, items, size);
+}
+
+void ZLIB_INTERNAL zpfree(voidpf opaque, voidpf ptr) {
+    zcfree(opaque, ptr);
+}
+
+void ZEXPORT zlibPoolRelease(void) {
+}
+
+#endif /* Z_TLS */
+
 #endif /* !Z_SOLO */
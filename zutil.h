@@ -239,13 +239,59 @@ extern z_const char * const z_errmsg[10]; /* indexed by 2-zlib_error */
    voidpf ZLIB_INTERNAL zcalloc(voidpf opaque, unsigned items,
                                 unsigned size);
    void ZLIB_INTERNAL zcfree(voidpf opaque, voidpf ptr);
+   voidpf ZLIB_INTERNAL zpalloc(voidpf opaque, unsigned items,
+                                unsigned size);
+   void ZLIB_INTERNAL zpfree(voidpf opaque, voidpf ptr);
+#endif
+
+/* thread-local storage for the allocation pools, see Z_POOL_ALLOC */
+#if !defined(Z_TLS) && !defined(Z_SOLO)
+#  if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#    define Z_TLS _Thread_local
+#  elif defined(__GNUC__)
+#    define Z_TLS __thread
+#  elif defined(_MSC_VER)
+#    define Z_TLS __declspec(thread)
+#  endif
 #endif
 
+/* allocation from a caller-provided workspace, see deflateInitWorkspace() */
+#define ZWORK_ALIGN 64      /* alignment of each allocation, a cache line */
+#define ZWORK_ROUND(n) (((z_size_t)(n) + ZWORK_ALIGN - 1) & \
+                        ~(z_size_t)(ZWORK_ALIGN - 1))
+#define ZWORK_BASE (ZWORK_ALIGN - 1 + ZWORK_ROUND(sizeof(struct z_work_s)))
+struct z_work_s {
+    Bytef *next;        /* next available byte in the workspace */
+    Bytef *end;         /* end of the workspace */
+    voidpf last;        /* most recent allocation, or Z_NULL */
+    Bytef *undo;        /* next before the most recent allocation */
+};
+voidpf ZLIB_INTERNAL zwinit(voidpf work, z_size_t size);
+voidpf ZLIB_INTERNAL zwalloc(voidpf opaque, unsigned items, unsigned size);
+void ZLIB_INTERNAL zwfree(voidpf opaque, voidpf ptr);
+
 #define ZALLOC(strm, items, size) \
            (*((strm)->zalloc))((strm)->opaque, (items), (size))
 #define ZFREE(strm, addr)  (*((strm)->zfree))((strm)->opaque, (voidpf)(addr))
 #define TRY_FREE(s, p) {if (p) ZFREE(s, p);}
 
+/* precomputed dictionary made by deflateMakeDictionary(), allocated as one
+   block with the head and prev tables and the window following the struct */
+struct z_dictionary_s {
+    uLong id;           /* Adler-32 of the whole dictionary */
+    uInt len;           /* number of dictionary bytes in window */
+    uInt w_bits;        /* window bits of the deflate streams it is for */
+    uInt hash_bits;     /* hash bits of the deflate streams it is for */
+    uInt hash_size;     /* number of entries in head */
+    uInt ins_h;         /* hash state after the dictionary */
+    uInt insert;        /* bytes at the end of window not yet hashed */
+    ushf *head;         /* deflate hash chain heads after the dictionary */
+    ushf *prev;         /* deflate hash chain links, len entries */
+    Bytef *window;      /* the last len bytes of the dictionary */
+    free_func zfree;    /* how to free this block */
+    voidpf opaque;
+};
+
 /* Reverse the bytes in a 32-bit value */
 #define ZSWAP32(q) ((((q) >> 24) & 0xff) + (((q) >> 8) & 0xff00) + \
                     (((q) & 0xff00) << 8) + (((q) & 0xff) << 24))